@@ -0,0 +1,278 @@
+/*
+ * Cycle benchmark of the main loop hot paths on the ATmega328P.
+ *
+ * Runs the firmware built from host/cycles_avr.c (pio run -e cycles) under
+ * simavr. The Si4703 simulator and the display emulator answer on the TWI
+ * of the simulated MCU and GPIO2 of the tuner drives PB0; their virtual
+ * clock follows the cycle counter of the CPU. Between the marks the
+ * firmware writes into GPIOR0 the cycles of every call are counted, the
+ * overhead of the marks (CYC_EMPTY) is subtracted.
+ *
+ * usage: bench_cycles firmware.elf [-o saved.txt] [-b baseline.txt] [-t percent]
+ *  -o  saves the average cycles per call as a baseline
+ *  -b  compares with a baseline, exits with 1 when a benchmark is slower
+ *      by more than -t percent (default 10)
+ * Without -o and -b the run compares with CYCLES_BASELINE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_twi.h>
+#include <simavr/avr_ioport.h>
+#include "hal.h"
+#include "twi_host.h"
+#include "oled.h"
+#include "si4703.h"
+#include "si4703_sim.h"
+#include "oled_emu.h"
+#include "bench_cycles.h"
+
+#ifndef CYCLES_BASELINE
+#define CYCLES_BASELINE "host/cycles_baseline.txt"
+#endif
+
+#define RUN_CYCLES  (60ULL * F_CPU)     // give up after 60 s of simulated time
+#define SYNC_CYCLES (F_CPU / 10000)     // models follow the CPU in 100 us steps
+
+static const char *names[CYC_COUNT] = {
+    "empty", "encoder_update", "putc_normal", "putc_double", "rds_idle", "rds_group",
+    "draw_full", "draw_idle", "draw_freq", "draw_scroll", "loop",
+};
+
+static const SimStation band[] = {
+    { 10110, 50, 0x2203, 5, "EVROPA 2", "Evropa 2 - MaXXimum muziky" },
+};
+
+typedef struct {
+    uint32_t calls;
+    uint64_t total;
+    uint32_t min, max;
+} CycleStats;
+
+static CycleStats stats[CYC_COUNT];
+static uint8_t current = CYCLES_END;
+static avr_cycle_count_t begin;
+static uint8_t done;
+
+static Si4703Sim sim;
+static OledEmu emu;
+
+static avr_irq_t *twi_in;
+static avr_irq_t *gpio2_irq;
+static const twi_host_device_t *selected;
+static avr_cycle_count_t synced;
+static uint8_t gpio2 = 1;
+
+/*
+ * Function for advancing the virtual clock of the models to the CPU cycle
+ * counter and passing the GPIO2 level of the tuner to the simulated MCU
+ */
+static void sync_models(avr_t *avr) {
+    uint64_t now_ns = avr->cycle * 1000000000ULL / F_CPU;
+    uint64_t synced_ns = synced * 1000000000ULL / F_CPU;
+    synced = avr->cycle;
+    while (now_ns > synced_ns) {
+        uint32_t step = (now_ns - synced_ns > 1000000) ? 1000000 : now_ns - synced_ns;
+        hal_advance_ns(step);
+        synced_ns += step;
+    }
+
+    // the model drives PINB of the host register file
+    uint8_t level = (PINB >> SI4703_INT_PIN) & 0x01;
+    if (level != gpio2) {
+        gpio2 = level;
+        avr_raise_irq(gpio2_irq, level);
+    }
+}
+
+/*
+ * Function for counting the cycles between the marks of the firmware
+ */
+static void mark_write(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+    if (v == CYCLES_DONE) {
+        done = 1;
+    } else if (v == CYCLES_END) {
+        if (current < CYC_COUNT) {
+            uint32_t cycles = avr->cycle - begin;
+            CycleStats *s = &stats[current];
+            if (s->calls == 0 || cycles < s->min) s->min = cycles;
+            if (cycles > s->max) s->max = cycles;
+            s->total += cycles;
+            s->calls++;
+        }
+        current = CYCLES_END;
+    } else {
+        current = v;
+        begin = avr->cycle;
+    }
+}
+
+/*
+ * Function for passing the TWI messages of simavr to the devices attached
+ * to the host TWI backend, the same models the other benchmarks use
+ */
+static void twi_message(avr_irq_t *irq, uint32_t value, void *param) {
+    avr_twi_msg_irq_t v;
+    v.u.v = value;
+
+    sync_models(param);
+
+    if (v.u.twi.msg & TWI_COND_STOP) {
+        if (selected && selected->stop) selected->stop(selected->ctx);
+        selected = NULL;
+    }
+    if (v.u.twi.msg & TWI_COND_START) {
+        // address byte with R/W bit, a repeated Start selects again
+        uint8_t ack = TWI_NACK;
+        selected = twi_host_get_device(v.u.twi.addr >> 1);
+        if (selected) ack = selected->start ? selected->start(selected->ctx, v.u.twi.addr & 0x01) : TWI_ACK;
+        if (ack == TWI_ACK) {
+            avr_raise_irq(twi_in, avr_twi_irq_msg(TWI_COND_ACK, v.u.twi.addr, 1));
+        } else {
+            selected = NULL;
+        }
+    }
+    if (!selected) return;
+
+    if (v.u.twi.msg & TWI_COND_WRITE) {
+        uint8_t ack = selected->write ? selected->write(selected->ctx, v.u.twi.data) : TWI_ACK;
+        if (ack == TWI_ACK) avr_raise_irq(twi_in, avr_twi_irq_msg(TWI_COND_ACK, v.u.twi.addr, 1));
+    }
+    if (v.u.twi.msg & TWI_COND_READ) {
+        uint8_t ack = (v.u.twi.msg & TWI_COND_ACK) ? TWI_ACK : TWI_NACK;
+        uint8_t data = selected->read ? selected->read(selected->ctx, ack) : 0xff;
+        avr_raise_irq(twi_in, avr_twi_irq_msg(TWI_COND_READ, v.u.twi.addr, data));
+    }
+}
+
+/*
+ * Function for reading a baseline saved by -o, returns the number of entries
+ */
+static uint8_t load_baseline(const char *path, uint32_t *baseline) {
+    char name[32];
+    unsigned long cycles;
+    uint8_t count = 0;
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return 0;
+
+    while (fscanf(f, "%31s %lu", name, &cycles) == 2) {
+        for (uint8_t i = 0; i < CYC_COUNT; i++) {
+            if (strcmp(name, names[i]) == 0) {
+                baseline[i] = cycles;
+                count++;
+            }
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    const char *out = NULL, *base = NULL;
+    unsigned tolerance = 10;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:b:t:")) != -1) {
+        switch (opt) {
+        case 'o': out = optarg; break;
+        case 'b': base = optarg; break;
+        case 't': tolerance = atoi(optarg); break;
+        default: optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s firmware.elf [-o saved.txt] [-b baseline.txt] [-t percent]\n", argv[0]);
+        return 2;
+    }
+    if (out == NULL && base == NULL) base = CYCLES_BASELINE;
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(argv[optind], &fw) != 0) {
+        fprintf(stderr, "cannot load %s\n", argv[optind]);
+        return 2;
+    }
+    avr_t *avr = avr_make_mcu_by_name("atmega328p");
+    if (avr == NULL) {
+        fprintf(stderr, "simavr has no atmega328p\n");
+        return 2;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &fw);
+    avr->frequency = F_CPU;
+
+    // models on the host side, GPIO2 goes to PB0 through sync_models()
+    sei();
+    si4703_sim_init(&sim, band, sizeof(band) / sizeof(band[0]));
+    sim.gpio2Pin = &PINB;
+    sim.gpio2Bit = SI4703_INT_PIN;
+    si4703_sim_attach(&sim);
+    oled_emu_init(&emu, OLED_EMU_SH1106);
+    oled_emu_attach(&emu, OLED_I2C_ADR);
+
+    twi_in = avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT),
+                            twi_message, avr);
+    gpio2_irq = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), SI4703_INT_PIN);
+    avr_raise_irq(gpio2_irq, gpio2);
+    // released buttons and encoder contacts, the pull-ups are not modelled
+    for (uint8_t pin = PD2; pin <= PD7; pin++) {
+        avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), pin), 1);
+    }
+    avr_register_io_write(avr, CYCLES_MARK_ADDR, mark_write, NULL);
+
+    int state = cpu_Running;
+    while (!done && state != cpu_Done && state != cpu_Crashed && avr->cycle < RUN_CYCLES) {
+        state = avr_run(avr);
+        if (avr->cycle - synced >= SYNC_CYCLES) sync_models(avr);
+    }
+    if (!done) {
+        fprintf(stderr, "firmware did not finish (state %d, %llu cycles)\n",
+                state, (unsigned long long)avr->cycle);
+        return 2;
+    }
+
+    uint32_t baseline[CYC_COUNT] = { 0 };
+    if (base && load_baseline(base, baseline) == 0) {
+        fprintf(stderr, "cannot read %s, save a baseline with -o first\n", base);
+        return 2;
+    }
+    FILE *saved = out ? fopen(out, "w") : NULL;
+    if (out && saved == NULL) {
+        fprintf(stderr, "cannot write %s\n", out);
+        return 2;
+    }
+
+    uint32_t overhead = stats[CYC_EMPTY].min;
+    uint8_t failed = 0;
+
+    printf("%-15s  calls      min      avg      max       us  baseline  result\n", "benchmark");
+    for (uint8_t i = 1; i < CYC_COUNT; i++) {
+        CycleStats *s = &stats[i];
+        if (s->calls == 0) {
+            printf("%-15s  not run\n", names[i]);
+            failed |= base != NULL;
+            continue;
+        }
+        uint32_t min = s->min - overhead, max = s->max - overhead;
+        uint32_t avg = s->total / s->calls - overhead;
+        const char *result = "";
+        if (baseline[i]) {
+            uint8_t ok = (uint64_t)avg * 100 <= (uint64_t)baseline[i] * (100 + tolerance);
+            result = ok ? "ok" : "SLOWER";
+            failed |= !ok;
+        }
+        printf("%-15s  %5lu  %7lu  %7lu  %7lu  %7.1f  %8lu  %s\n", names[i],
+               (unsigned long)s->calls, (unsigned long)min, (unsigned long)avg, (unsigned long)max,
+               avg * 1e6 / F_CPU, (unsigned long)baseline[i], result);
+        if (saved) fprintf(saved, "%s %lu\n", names[i], (unsigned long)avg);
+    }
+    if (saved) fclose(saved);
+
+    return failed;
+}
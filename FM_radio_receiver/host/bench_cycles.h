@@ -0,0 +1,35 @@
+/*
+ * Protocol between the cycle benchmark firmware (host/cycles_avr.c) and its
+ * simavr runner (host/bench_cycles.c).
+ *
+ * The firmware writes a benchmark id into GPIOR0 right before the measured
+ * call and CYCLES_END right after it. The runner sees both writes and adds
+ * the CPU cycles in between to the statistics of the id. CYCLES_DONE ends
+ * the run.
+ */
+
+#ifndef BENCH_CYCLES_H
+#define BENCH_CYCLES_H
+
+#define CYCLES_MARK_ADDR 0x3E   // GPIOR0 in the data space of the ATmega328P
+
+#define CYCLES_END  0xFE
+#define CYCLES_DONE 0xFF
+
+// benchmark ids, the names are in bench_cycles.c
+enum {
+    CYC_EMPTY,          // two marks with nothing between, the overhead
+    CYC_ENCODER,        // encoder_update(), as called by the Timer0 interrupt
+    CYC_PUTC_NORMAL,    // oled_putc() NORMALSIZE
+    CYC_PUTC_DOUBLE,    // oled_putc() DOUBLESIZE
+    CYC_RDS_IDLE,       // si4703_update_rds() with no group captured
+    CYC_RDS_GROUP,      // si4703_update_rds() decoding the captured groups
+    CYC_DRAW_FULL,      // draw_display() of a cleared screen
+    CYC_DRAW_IDLE,      // draw_display() with nothing changed
+    CYC_DRAW_FREQ,      // draw_display() after a tuning step
+    CYC_DRAW_SCROLL,    // draw_display() scrolling the RadioText
+    CYC_LOOP,           // one main loop iteration without input or events
+    CYC_COUNT
+};
+
+#endif
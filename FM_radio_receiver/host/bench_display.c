@@ -0,0 +1,258 @@
+/*
+ * Display regression run of draw_display() and draw_spectrum()
+ * (src/display.c) against the SH1106 emulator, or the SSD1306 one when the
+ * oled library is built for it.
+ *
+ * Every step changes the state shown on the screen the way main.c does,
+ * redraws it and checks that
+ *  - the panel of the emulator equals the frame buffer of the oled library,
+ *  - the update did not cost more I2C bytes than its budget.
+ * Built with OLED_SHADOW the full frame steps must cost next to nothing.
+ * With a directory argument a PBM snapshot of every step is saved there.
+ * The exit status is 1 if any check failed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "oled.h"
+#include "si4703.h"
+#include "si4703_sim.h"
+#include "bandscan.h"
+#include "oled_emu.h"
+#include "display.h"
+
+// state shown on the display, owned by main.c in the firmware
+uint16_t current_freq = 9500;
+uint8_t current_vol = 10;
+uint8_t is_muted = 0;
+RdsInfo rdsData;
+
+static const SimStation band[] = {
+    {  8950, 24, 0x2202, 10, "CRO 2   ", NULL },
+    {  9500, 30, 0x2201, 10, "RADIO 1 ", NULL },
+    { 10110, 50, 0x2203,  5, "EVROPA 2", NULL },
+    { 10550, 41, 0x2204, 10, "IMPULS  ", NULL },
+};
+
+#define DISPLAY_PERIOD_MS 33    // period of the display task in main.c
+
+static Si4703Sim sim;
+static OledEmu emu;
+
+static void step_first(void) {
+    rds_clear(&rdsData);
+    si4703_set_freq(current_freq);
+}
+
+static void step_idle(void) {
+}
+
+static void step_volume(void) {
+    current_vol = 11;
+}
+
+static void step_mute(void) {
+    is_muted = 1;
+}
+
+static void step_unmute(void) {
+    is_muted = 0;
+}
+
+static void step_tune(void) {
+    current_freq = 10110;
+    si4703_set_freq(current_freq);
+    rds_clear(&rdsData);
+}
+
+static void step_knob(void) {
+    // one encoder step, only the last digit changes
+    current_freq += 10;
+    si4703_request_freq(current_freq);
+}
+
+static void step_station(void) {
+    strcpy(rdsData.stationName, "EVROPA 2");
+    rdsData.updated |= RDS_UPD_PS;
+}
+
+static void step_clock(void) {
+    rdsData.hour = 14;
+    rdsData.minute = 5;
+    rdsData.flags |= RDS_FLAG_CT;
+    rdsData.updated |= RDS_UPD_CT;
+}
+
+static void step_radiotext(void) {
+    strcpy(rdsData.radioText, "Evropa 2 - MaXXimum muziky, nejvetsi hity");
+    rdsData.updated |= RDS_UPD_RT;
+}
+
+static void step_scroll(void) {
+    // draw_display() below is the 8th call, RT_SCROLL_TICKS in display.c
+    for (uint8_t i = 0; i < 7; i++) draw_display();
+    oled_emu_frame(&emu);
+}
+
+static void step_spectrum(void) {
+    scan_start(SCAN_FULL, SCAN_DWELL_MS, 0, NULL);
+}
+
+/*
+ * Function for polling the scan like the tuner task of main.c, the display
+ * task runs every DISPLAY_PERIOD_MS
+ */
+static uint8_t scan_step(void) {
+    uint8_t busy = scan_poll() == SCAN_BUSY;
+    current_freq = FREQ_MIN + scan_get_progress() * 10;
+    _delay_ms(SI4703_POLL_MS);
+    return busy;
+}
+
+static void step_channel(void) {
+    uint8_t channel = scan_get_progress();
+    while (scan_get_progress() == channel) scan_step();
+    // the tune of the next channel started after the measured one
+    scan_step();
+}
+
+static void step_scan(void) {
+    uint16_t ms = 0;
+    while (scan_step()) {
+        ms += SI4703_POLL_MS;
+        if (ms >= DISPLAY_PERIOD_MS) {
+            ms = 0;
+            draw_spectrum();
+        }
+    }
+    current_freq = si4703_get_tuning_freq();
+}
+
+static void step_splash(void) {
+    oled_clear_buffer();
+    oled_charMode(DOUBLESIZE);
+    oled_gotoxy(1, 2);
+    oled_puts("FM RADIO");
+}
+
+static void step_block(void) {
+    // pages 2-4, on the SSD1306 one window of the asynchronous flush
+    oled_fillRect(16, 16, 63, 39, WHITE);
+}
+
+static void step_unblock(void) {
+    // back to what the panel showed before step_block(), with OLED_SHADOW
+    // the signatures of every page of the window have to know the block
+    oled_fillRect(16, 16, 63, 39, BLACK);
+}
+
+static void flush_async(void) {
+    oled_flush_async();
+}
+
+static void step_radio(void) {
+    rds_clear(&rdsData);
+}
+
+typedef struct {
+    const char *name;
+    void (*change)(void);
+    void (*draw)(void);
+    uint32_t budget;    // I2C bytes the update may cost, address bytes included
+} Step;
+
+// bytes of oled_display() or oled_clrscr(), a whole frame without OLED_SHADOW
+#if OLED_SHADOW
+# define FRAME_BUDGET(_changed) (_changed)
+#else
+# define FRAME_BUDGET(_changed) 1110
+#endif
+
+// the scan step covers every display update of a whole band scan, a full
+// frame per update would be about 200 KB
+static const Step steps[] = {
+    { "first",     step_first,     draw_display,   450 },
+    { "idle",      step_idle,      draw_display,     0 },
+    { "volume",    step_volume,    draw_display,    30 },
+    { "mute",      step_mute,      draw_display,   110 },
+    { "unmute",    step_unmute,    draw_display,   110 },
+    { "tune",      step_tune,      draw_display,   300 },
+    { "knob",      step_knob,      draw_display,    70 },
+    { "station",   step_station,   draw_display,    80 },
+    { "clock",     step_clock,     draw_display,    50 },
+    { "radiotext", step_radiotext, draw_display,   150 },
+    { "scroll",    step_scroll,    draw_display,   150 },
+    { "spectrum",  step_spectrum,  draw_spectrum,  750 },
+    { "channel",   step_channel,   draw_spectrum,   60 },
+    { "scan",      step_scan,      draw_spectrum, 7000 },
+    { "frame",     step_idle,      oled_display,  FRAME_BUDGET(0) },
+    { "splash",    step_splash,    oled_display,  FRAME_BUDGET(900) },
+    { "clear",     step_idle,      oled_clrscr,   FRAME_BUDGET(300) },
+    { "block",     step_block,     flush_async,    200 },
+    { "unblock",   step_unblock,   oled_display,  FRAME_BUDGET(200) },
+    { "radio",     step_radio,     draw_display,   900 },
+};
+
+/*
+ * Function for comparing the panel with the frame buffer, returns the number of wrong pixels
+ */
+static uint16_t compare(void) {
+    uint16_t wrong = 0;
+    for (uint8_t y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (uint8_t x = 0; x < DISPLAY_WIDTH; x++) {
+            if (oled_emu_pixel(&emu, x, y) != (oled_check_buffer(x, y) ? 1 : 0)) wrong++;
+        }
+    }
+    return wrong;
+}
+
+int main(int argc, char *argv[]) {
+    const char *dir = argc > 1 ? argv[1] : NULL;
+    uint8_t failed = 0;
+
+    sei();
+    si4703_sim_init(&sim, band, sizeof(band) / sizeof(band[0]));
+    sim.gpio2Pin = &SI4703_INT_PINREG;
+    sim.gpio2Bit = SI4703_INT_PIN;
+    si4703_sim_attach(&sim);
+    si4703_init(&PORTC, &DDRC, PC0);
+
+#if defined (SSD1306) || defined (SSD1309)
+    oled_emu_init(&emu, OLED_EMU_SSD1306);
+#else
+    oled_emu_init(&emu, OLED_EMU_SH1106);
+#endif
+    oled_emu_attach(&emu, OLED_I2C_ADR);
+    oled_init(OLED_DISP_ON);
+    OledEmuCounters init = oled_emu_frame(&emu);
+    printf("oled_init: %lu bytes, %lu transactions\n\n",
+           (unsigned long)init.bytes, (unsigned long)init.transactions);
+
+    printf("step        bytes  budget  transactions  data  command  pixels  result\n");
+    for (uint8_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        steps[i].change();
+        steps[i].draw();
+
+        OledEmuCounters frame = oled_emu_frame(&emu);
+        uint16_t wrong = compare();
+        uint8_t ok = wrong == 0 && frame.bytes <= steps[i].budget;
+        failed |= !ok;
+
+        printf("%-10s  %5lu  %6lu  %12lu  %4lu  %7lu  %6u  %s\n", steps[i].name,
+               (unsigned long)frame.bytes, (unsigned long)steps[i].budget, (unsigned long)frame.transactions,
+               (unsigned long)frame.dataBytes, (unsigned long)frame.commandBytes, wrong,
+               ok ? "ok" : "FAIL");
+
+        if (dir) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s/%02u_%s.pbm", dir, i, steps[i].name);
+            if (oled_emu_write_pbm(&emu, path)) {
+                printf("cannot write %s\n", path);
+                failed = 1;
+            }
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,133 @@
+/*
+ * Host benchmark of the driver libraries, built by the `native`
+ * PlatformIO environment or by CMake (see CMakeLists.txt).
+ *
+ * Prints wall-clock cost of the pure logic on the PC and the I2C traffic
+ * and bus time the same code would cause on the target.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "twi_host.h"
+#include "oled.h"
+#include "rds.h"
+
+#define RDS_GROUPS   200000UL
+#define OLED_FRAMES  100
+#define OLED_CHARS   200000UL
+
+/*
+ * Function for building an RDS group 0A (PS segment) or 2A (RadioText segment)
+ */
+static void make_group(uint16_t blocks[4], uint16_t n) {
+    static const char ps[] = "BENCH FM";
+    static const char rt[] = "Host benchmark of the RDS decoder, 64 characters of RadioText...";
+
+    blocks[0] = 0x2204;
+    if (n & 1) {
+        uint8_t seg = (n >> 1) & 0x03;
+        blocks[1] = (0x0 << 12) | (10 << 5) | seg;
+        blocks[2] = 0;
+        blocks[3] = (ps[2*seg] << 8) | ps[2*seg + 1];
+    } else {
+        uint8_t seg = (n >> 1) & 0x0F;
+        blocks[1] = (0x2 << 12) | (10 << 5) | seg;
+        blocks[2] = (rt[4*seg] << 8) | rt[4*seg + 1];
+        blocks[3] = (rt[4*seg + 2] << 8) | rt[4*seg + 3];
+    }
+}
+
+static void bench_rds(void) {
+    RdsInfo info;
+    uint16_t blocks[4];
+
+    rds_clear(&info);
+    uint64_t t0 = hal_host_ns();
+    for (uint32_t n = 0; n < RDS_GROUPS; n++) {
+        make_group(blocks, n);
+        rds_decode_group(&info, blocks, 0);
+    }
+    uint64_t t1 = hal_host_ns();
+
+    printf("rds_decode_group: %lu groups, %.1f ns/group, PS \"%s\"\n",
+           RDS_GROUPS, (double)(t1 - t0) / RDS_GROUPS, info.stationName);
+}
+
+/*
+ * Function for drawing the status line the way main.c does every display period
+ */
+static void draw_status(uint8_t frame) {
+    char buffer[22];
+
+    oled_gotoxy(0, 3);
+    sprintf(buffer, "Vol:%2d RSSI:%2d", 10, 30 + (frame % 8));
+    oled_puts(buffer);
+}
+
+/*
+ * Function for the flush of the display task, the host TWI sends the queued
+ * transactions before it returns
+ */
+static void flush_async(void) {
+    oled_flush_async();
+}
+
+static void bench_oled(const char *name, void (*flush)(void)) {
+    twi_host_stats_t stats;
+
+    oled_clear_buffer();
+    oled_display();
+    twi_host_reset_stats();
+
+    uint64_t t0 = hal_host_ns();
+    for (uint8_t frame = 0; frame < OLED_FRAMES; frame++) {
+        draw_status(frame);
+        flush();
+    }
+    uint64_t t1 = hal_host_ns();
+
+    twi_host_get_stats(&stats);
+    printf("%-16s: %lu bytes/frame, %lu transactions/frame, %lu us bus/frame, %.1f us host/frame\n",
+           name,
+           (unsigned long)(stats.bytes / OLED_FRAMES),
+           (unsigned long)(stats.transactions / OLED_FRAMES),
+           (unsigned long)(stats.bus_ns / 1000 / OLED_FRAMES),
+           (double)(t1 - t0) / 1000.0 / OLED_FRAMES);
+}
+
+/*
+ * Function for the cost of oled_putc() into the frame buffer, no flush
+ */
+static void bench_putc(const char *name, uint8_t mode) {
+    static const char text[] = "101.5 MHz";
+
+    oled_charMode(mode);
+    uint64_t t0 = hal_host_ns();
+    for (uint32_t n = 0; n < OLED_CHARS; n++) {
+        if (n % (sizeof(text) - 1) == 0) oled_gotoxy(0, 0);
+        oled_putc(text[n % (sizeof(text) - 1)]);
+    }
+    uint64_t t1 = hal_host_ns();
+    oled_charMode(NORMALSIZE);
+
+    printf("%-16s: %lu chars, %.1f ns/char\n", name, OLED_CHARS, (double)(t1 - t0) / OLED_CHARS);
+}
+
+int main(void) {
+    // acknowledge every byte sent to the display
+    static const twi_host_device_t oled_sink = {0};
+    twi_host_attach(OLED_I2C_ADR, &oled_sink);
+
+    sei();
+    oled_init(OLED_DISP_ON);
+
+    bench_rds();
+    bench_oled("oled_display", oled_display);
+    bench_oled("oled_flush_dirty", oled_flush_dirty);
+    bench_oled("oled_flush_async", flush_async);
+    bench_putc("putc NORMALSIZE", NORMALSIZE);
+    bench_putc("putc DOUBLESIZE", DOUBLESIZE);
+
+    return 0;
+}
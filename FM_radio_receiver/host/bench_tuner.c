@@ -0,0 +1,288 @@
+/*
+ * Tune, seek and RDS scenarios of si4703.c against the Si4703 simulator.
+ *
+ * Every scenario runs on the virtual clock of the HAL, so the numbers are
+ * the same on every run and every machine. Latencies are virtual time
+ * from the call to the result, bytes are what the driver moved over I2C.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "si4703.h"
+#include "si4703_sim.h"
+#include "bandscan.h"
+
+#define RDS_RUN_MS 20000UL     // give up an RDS scenario after this time
+#define SPIN_TUNES 5           // most tunes of an encoder spin faster than a tune
+
+static const SimStation band[] = {
+    {  8820, 42, 0x2201, 10, "RADIO 1 ", "Radio 1 - alternative music from Prague" },
+    {  9130, 35, 0x2202,  1, "CRo 1   ", "Cesky rozhlas Radiozurnal, zpravy kazdou hodinu" },
+    {  9550, 18, 0x0000,  0, NULL, NULL },  // weak station without RDS
+    { 10110, 50, 0x2203,  5, "EVROPA 2", "Evropa 2 - MaXXimum muziky" },
+    { 10450, 28, 0x2204, 15, "BEAT    ", NULL },
+};
+
+static Si4703Sim sim;
+static uint8_t failed;
+
+/*
+ * Function for (re)starting the simulated chip and the driver
+ */
+static void start(const SimStation *stations, uint8_t count) {
+    si4703_sim_init(&sim, stations, count);
+    sim.gpio2Pin = &SI4703_INT_PINREG;
+    sim.gpio2Bit = SI4703_INT_PIN;
+    si4703_sim_attach(&sim);
+    si4703_init(&PORTC, &DDRC, PC0);
+}
+
+static void scenario_init(void) {
+    si4703_reset_bus_bytes();
+    uint64_t t0 = hal_micros();
+    start(band, sizeof(band) / sizeof(band[0]));
+    printf("init: %lu us, %lu bytes\n",
+           (unsigned long)(hal_micros() - t0), (unsigned long)si4703_get_bus_bytes());
+
+    // the same power-up polled like the tuner task, with the tune of a request after it
+    uint32_t longest = 0;
+    Si4703Status status;
+    si4703_reset_bus_bytes();
+    t0 = hal_micros();
+    si4703_reset_start(&PORTC, &DDRC, PC0);
+    uint32_t blocked = hal_micros() - t0;
+    si4703_request_freq(band[3].freq);
+    do {
+        uint64_t call = hal_micros();
+        status = si4703_poll();
+        if (hal_micros() - call > longest) longest = hal_micros() - call;
+        _delay_ms(SI4703_POLL_MS);
+    } while (status == SI4703_BUSY || status == SI4703_DONE);
+    printf("reset: %lu us to %u %s, start %lu us, longest poll %lu us, %lu bytes\n",
+           (unsigned long)(hal_micros() - t0), band[3].freq,
+           si4703_sim_get_freq(&sim) == band[3].freq ? "ok" : "WRONG",
+           (unsigned long)blocked, (unsigned long)longest, (unsigned long)si4703_get_bus_bytes());
+}
+
+static void scenario_tune(void) {
+    printf("\ntune    freq  result  latency_us  bytes\n");
+    for (uint8_t i = 0; i < sizeof(band) / sizeof(band[0]); i++) {
+        si4703_reset_bus_bytes();
+        uint64_t t0 = hal_micros();
+        si4703_set_freq(band[i].freq);
+        printf("      %6u  %-6s  %10lu  %5lu\n", band[i].freq,
+               si4703_sim_get_freq(&sim) == band[i].freq ? "ok" : "WRONG",
+               (unsigned long)(hal_micros() - t0), (unsigned long)si4703_get_bus_bytes());
+    }
+}
+
+/*
+ * Function for one seek polled the way main.c does it, returns the final status
+ */
+static Si4703Status seek_once(uint8_t direction, uint16_t *freq, uint32_t *latency, uint32_t *lag) {
+    Si4703Status status;
+    uint64_t t0 = hal_micros();
+
+    si4703_seek_start(direction);
+    while ((status = si4703_poll()) == SI4703_BUSY) {
+        _delay_ms(SI4703_POLL_MS);
+    }
+    *latency = hal_micros() - t0;
+    *lag = hal_micros() - sim.stcUs;    // STC on the chip to the result in the driver
+    *freq = si4703_get_freq();
+    return status;
+}
+
+static void scenario_seek(void) {
+    static const char *names[] = { "idle", "busy", "done", "fail", "timeout", "cancel" };
+    uint16_t freq;
+    uint32_t latency, lag;
+
+    printf("\nseek    from    to  result   latency_us  stc_lag_us  bytes\n");
+    si4703_set_freq(FREQ_MIN);
+    for (uint8_t i = 0; i <= sizeof(band) / sizeof(band[0]); i++) {
+        uint16_t from = si4703_get_freq();
+        si4703_reset_bus_bytes();
+        Si4703Status status = seek_once(SEEK_UP, &freq, &latency, &lag);
+        printf("      %5u %5u  %-7s  %10lu  %10lu  %5lu\n", from, freq, names[status],
+               (unsigned long)latency, (unsigned long)lag, (unsigned long)si4703_get_bus_bytes());
+    }
+
+    // empty band, the chip needs 206 steps for a whole round
+    start(NULL, 0);
+    si4703_reset_bus_bytes();
+    Si4703Status status = seek_once(SEEK_UP, &freq, &latency, &lag);
+    printf("empty %5u %5u  %-7s  %10lu  %10s  %5lu\n", FREQ_MIN, freq, names[status],
+           (unsigned long)latency, "-", (unsigned long)si4703_get_bus_bytes());
+}
+
+/*
+ * Function for polling until the running operation ends, returns its status
+ */
+static Si4703Status wait_done(void) {
+    Si4703Status status;
+    while ((status = si4703_poll()) == SI4703_BUSY) {
+        _delay_ms(SI4703_POLL_MS);
+    }
+    return status;
+}
+
+/*
+ * Function for spinning the encoder over 5 MHz in 0.1 MHz steps, one
+ * request every step_ms, the driver is polled like the tuner task does.
+ * The spin fails with more than max_tunes tunes.
+ */
+static void spin_latest(uint16_t from, uint16_t to, uint16_t step_ms, uint16_t max_tunes) {
+    si4703_set_freq(from);
+    uint32_t tunes = sim.tuneCount;
+    uint64_t t0 = hal_micros();
+    for (uint16_t freq = from + 10; freq <= to; freq += 10) {
+        si4703_request_freq(freq);
+        for (uint16_t ms = 0; ms < step_ms; ms += SI4703_POLL_MS) {
+            si4703_poll();
+            _delay_ms(SI4703_POLL_MS);
+        }
+    }
+    // the last tune may already be over, then the status is SI4703_IDLE
+    uint64_t t1 = hal_micros();
+    Si4703Status status = wait_done();
+    uint8_t ok = status != SI4703_TIMEOUT && si4703_sim_get_freq(&sim) == to && sim.tuneCount - tunes <= max_tunes;
+    failed |= !ok;
+    printf("latest %3u ms  %5lu  %-6s  %8lu  %12lu\n", step_ms, (unsigned long)(sim.tuneCount - tunes),
+           ok ? "ok" : "WRONG",
+           (unsigned long)(hal_micros() - t0), (unsigned long)(hal_micros() - t1));
+}
+
+static void scenario_spin(void) {
+    uint16_t from = band[0].freq, to = from + 500;
+
+    printf("\nspin %u -> %u     tunes  result  total_us  last_to_done\n", from, to);
+
+    // one blocking tune per step, as main.c did
+    si4703_set_freq(from);
+    uint32_t tunes = sim.tuneCount;
+    uint64_t t0 = hal_micros();
+    for (uint16_t freq = from + 10; freq <= to; freq += 10) {
+        si4703_set_freq(freq);
+    }
+    printf("blocking       %5lu  %-6s  %8lu  %12s\n", (unsigned long)(sim.tuneCount - tunes),
+           si4703_sim_get_freq(&sim) == to ? "ok" : "WRONG", (unsigned long)(hal_micros() - t0), "-");
+
+    // latest target through the request mailbox
+    spin_latest(from, to, 10, SPIN_TUNES);
+    spin_latest(from, to, 50, SPIN_TUNES);
+    spin_latest(from, to, 100, 50);     // slower than a tune, every step is heard
+}
+
+/*
+ * Function for one band scan polled like the tuner task, RDS decoded like the RDS task,
+ * with requested the scan starts while a tune request is still pending
+ */
+static void scan_run(uint8_t mode, uint16_t dwell_ms, uint16_t pi_ms, uint8_t requested) {
+    static const char *modes[] = { "full", "seek" };
+    RdsInfo info;
+    const ScanStation *stations;
+    uint8_t pis = 0, matched = 0;
+    uint16_t restore = requested ? band[1].freq : band[0].freq;
+
+    start(band, sizeof(band) / sizeof(band[0]));
+    si4703_set_freq(band[0].freq);
+    rds_clear(&info);
+    si4703_reset_bus_bytes();
+    // a knob turn the tuner task did not tune yet
+    if (requested) si4703_request_freq(restore);
+
+    scan_start(mode, dwell_ms, pi_ms, &info);
+    while (scan_poll() == SCAN_BUSY) {
+        si4703_update_rds(&info);
+        _delay_ms(SI4703_POLL_MS);
+    }
+
+    uint8_t count = scan_get_stations(&stations);
+    for (uint8_t i = 0; i < count; i++) {
+        if (stations[i].pi) pis++;
+        for (uint8_t j = 0; j < sizeof(band) / sizeof(band[0]); j++) {
+            if (band[j].freq == FREQ_MIN + stations[i].channel * 10 &&
+                band[j].pi == stations[i].pi) matched++;
+        }
+    }
+    uint8_t ok = si4703_sim_get_freq(&sim) == restore;
+    failed |= !ok;
+    printf("      %-4s  %5u  %5u  %8lu  %6lu  %8u  %3u  %7u/%u  %s%s\n", modes[mode], dwell_ms, pi_ms,
+           (unsigned long)scan_get_time_ms(), (unsigned long)si4703_get_bus_bytes(), count, pis,
+           matched, (unsigned)(sizeof(band) / sizeof(band[0])),
+           ok ? "ok" : "WRONG", requested ? ", requested" : "");
+}
+
+static void scenario_scan(void) {
+    printf("\nscan  mode  dwell  pi_ms   time_ms   bytes  stations  pis  matched  restored\n");
+    scan_run(SCAN_FULL, 0, 0, 0);
+    scan_run(SCAN_FULL, SCAN_DWELL_MS, 0, 0);
+    scan_run(SCAN_FULL, SCAN_DWELL_MS, SCAN_PI_MS, 0);
+    scan_run(SCAN_FULL, SCAN_DWELL_MS, 1000, 0);
+    scan_run(SCAN_SEEK, SCAN_DWELL_MS, SCAN_PI_MS, 0);
+    scan_run(SCAN_SEEK, SCAN_DWELL_MS, 1000, 0);
+    scan_run(SCAN_FULL, 0, 0, 1);
+}
+
+/*
+ * Function for receiving RDS with si4703_update_rds() called every period_ms
+ */
+static void rds_run(uint16_t period_ms, uint8_t error_rate) {
+    RdsInfo info;
+    const SimStation *station = &band[0];
+    uint32_t ps_ms = 0, rt_ms = 0;
+
+    start(band, sizeof(band) / sizeof(band[0]));
+    sim.blockErrorRate = error_rate;
+    sim.seed = 0x12345678;
+    si4703_set_freq(station->freq);
+    rds_clear(&info);
+
+    uint16_t received = si4703_get_rds_received();
+    uint16_t dropped = si4703_get_rds_dropped();
+    uint32_t sent = sim.groupsSent, missed = sim.groupsMissed;
+    uint64_t t0 = hal_micros();
+    uint32_t elapsed = 0;
+
+    while (elapsed < RDS_RUN_MS && !(ps_ms && rt_ms)) {
+        _delay_ms(period_ms);
+        si4703_update_rds(&info);
+        elapsed = (hal_micros() - t0) / 1000;
+        if (!ps_ms && strcmp(info.stationName, station->ps) == 0) ps_ms = elapsed;
+        if (!rt_ms && strcmp(info.radioText, station->rt) == 0) rt_ms = elapsed;
+    }
+
+    printf("      %6u  %5u/256  %6lu  %6lu  %6lu  %6u  %6u  %6lu  %6lu\n",
+           period_ms, error_rate,
+           (unsigned long)(sim.groupsSent - sent), (unsigned long)(sim.groupsMissed - missed),
+           (unsigned long)elapsed,
+           (uint16_t)(si4703_get_rds_received() - received), (uint16_t)(si4703_get_rds_dropped() - dropped),
+           (unsigned long)ps_ms, (unsigned long)rt_ms);
+}
+
+static void scenario_rds(void) {
+    static const uint16_t periods[] = { 10, 100, 500, 1000 };
+
+    printf("\nrds   period     errors    sent  missed  run_ms  captured dropped  ps_ms   rt_ms\n");
+    for (uint8_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++) {
+        rds_run(periods[i], 0);
+    }
+    for (uint8_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++) {
+        rds_run(periods[i], 20);
+    }
+}
+
+int main(void) {
+    sei();
+
+    scenario_init();
+    scenario_tune();
+    scenario_seek();
+    scenario_spin();
+    scenario_scan();
+    scenario_rds();
+
+    return failed;
+}
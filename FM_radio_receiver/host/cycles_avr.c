@@ -0,0 +1,163 @@
+/*
+ * Firmware of the cycle benchmark (pio run -e cycles), runs under simavr
+ * driven by host/bench_cycles.c and never on the board.
+ *
+ * Every hot path of the main loop is called between two writes of GPIOR0
+ * (see bench_cycles.h). The tuner and the display are models in the runner,
+ * so the drivers see the same I2C answers and GPIO2 interrupts as on the
+ * board and the bus waits are part of the counted cycles.
+ */
+
+#include <string.h>
+#include "hal.h"
+#include "twi.h"
+#include "debounce.h"
+#include "oled.h"
+#include "si4703.h"
+#include "rotary_encoder.h"
+#include "display.h"
+#include "bench_cycles.h"
+
+#define BEGIN(id) (GPIOR0 = (id))
+#define END()     (GPIOR0 = CYCLES_END)
+
+#define REPEAT 16   // calls of the short benchmarks
+
+// state shown on the display, owned by main.c in the firmware
+uint16_t current_freq = 10110;
+uint8_t current_vol = 10;
+uint8_t is_muted = 0;
+RdsInfo rdsData;
+
+static void bench_encoder(void) {
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        BEGIN(CYC_ENCODER);
+        encoder_update();
+        END();
+    }
+}
+
+static void bench_putc(void) {
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        oled_charMode(NORMALSIZE);
+        oled_gotoxy(i, 4);
+        BEGIN(CYC_PUTC_NORMAL);
+        oled_putc('0' + (i % 10));
+        END();
+    }
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        oled_charMode(DOUBLESIZE);
+        oled_gotoxy((i % 10) * 2, 0);
+        BEGIN(CYC_PUTC_DOUBLE);
+        oled_putc('0' + (i % 10));
+        END();
+    }
+    oled_charMode(NORMALSIZE);
+    oled_clrscr();
+}
+
+static void bench_rds(void) {
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        // nothing captured since the previous call
+        si4703_update_rds(&rdsData);
+        BEGIN(CYC_RDS_IDLE);
+        si4703_update_rds(&rdsData);
+        END();
+    }
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        // one or two groups arrive meanwhile (87.6 ms per group)
+        _delay_ms(100);
+        BEGIN(CYC_RDS_GROUP);
+        si4703_update_rds(&rdsData);
+        END();
+    }
+}
+
+/*
+ * Function for drawing outside of a measurement, draw_display() only queues
+ * its flush and the display task of main.c runs long after the bus is idle
+ */
+static void draw_idle_bus(void) {
+    draw_display();
+    while (oled_flush_busy());
+}
+
+static void bench_display(void) {
+    BEGIN(CYC_DRAW_FULL);
+    draw_display();
+    END();
+    while (oled_flush_busy());
+
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        BEGIN(CYC_DRAW_IDLE);
+        draw_display();
+        END();
+        while (oled_flush_busy());
+    }
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        current_freq += 10;
+        BEGIN(CYC_DRAW_FREQ);
+        draw_display();
+        END();
+        while (oled_flush_busy());
+    }
+
+    strcpy(rdsData.radioText, "Evropa 2 - MaXXimum muziky, nejvetsi hity");
+    rdsData.updated |= RDS_UPD_RT;
+    draw_idle_bus();
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        // the 8th call moves the text, RT_SCROLL_TICKS in display.c
+        for (uint8_t j = 0; j < 7; j++) draw_idle_bus();
+        BEGIN(CYC_DRAW_SCROLL);
+        draw_display();
+        END();
+        while (oled_flush_busy());
+    }
+}
+
+/*
+ * Function for the work of the main loop tasks when no input and no event
+ * is pending, the same calls as the RDS, tuner and input tasks of main.c
+ */
+static void loop_iteration(void) {
+    si4703_update_rds(&rdsData);
+    si4703_poll();
+    if (encoder_get_delta() != 0) return;
+    while (debounce_get_event() != DEBOUNCE_NONE);
+}
+
+static void bench_loop(void) {
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        BEGIN(CYC_LOOP);
+        loop_iteration();
+        END();
+    }
+}
+
+int main(void) {
+    sei();
+    twi_init();
+    oled_init(OLED_DISP_ON);
+    oled_clrscr();
+    encoder_init();
+    debounce_init();
+
+    si4703_init(&PORTC, &DDRC, PC0);
+    si4703_set_volume(current_vol);
+    si4703_set_freq(current_freq);
+    rds_clear(&rdsData);
+
+    for (uint8_t i = 0; i < REPEAT; i++) {
+        BEGIN(CYC_EMPTY);
+        END();
+    }
+    bench_encoder();
+    bench_putc();
+    bench_rds();
+    bench_display();
+    bench_loop();
+
+    GPIOR0 = CYCLES_DONE;
+    cli();
+    while (1);
+}
@@ -0,0 +1,190 @@
+ /**
+  * @file oled_emu.c
+  * @defgroup oled_emu OLED Controller Emulator <oled_emu.c>
+  * @code #include <oled_emu.h> @endcode
+  *
+  * @brief SH1106/SSD1306 display controller emulator for host builds
+  */
+
+#include "oled_emu.h"
+#include "twi_host.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Function for returning the length of a command including its argument bytes
+ */
+static uint8_t command_length(const OledEmu *emu, uint8_t cmd) {
+    switch (cmd) {
+    case 0x81:  // contrast
+    case 0x8D:  // SSD1306 charge pump
+    case 0xA8:  // multiplex ratio
+    case 0xAD:  // SH1106 DC-DC
+    case 0xD3:  // display offset
+    case 0xD5:  // clock divide
+    case 0xD9:  // pre-charge period
+    case 0xDA:  // COM pins
+    case 0xDB:  // VCOMH
+        return 2;
+    }
+    if (emu->controller == OLED_EMU_SSD1306) {
+        switch (cmd) {
+        case 0x20: return 2;                // memory addressing mode
+        case 0x21: case 0x22: return 3;     // column and page window
+        case 0xA3: return 3;                // vertical scroll area
+        case 0x26: case 0x27: return 7;     // horizontal scroll
+        case 0x29: case 0x2A: return 6;     // vertical and horizontal scroll
+        }
+    }
+    return 1;
+}
+
+/*
+ * Function for executing a complete command
+ */
+static void command(OledEmu *emu, const uint8_t *cmd) {
+    if (cmd[0] <= 0x0F) {
+        emu->column = (emu->column & 0xF0) | cmd[0];
+    } else if (cmd[0] <= 0x1F) {
+        emu->column = (emu->column & 0x0F) | ((cmd[0] & 0x0F) << 4);
+    } else if (cmd[0] >= 0xB0 && cmd[0] <= 0xB7) {
+        emu->page = cmd[0] & 0x07;
+    } else if (cmd[0] == 0xAE || cmd[0] == 0xAF) {
+        emu->displayOn = cmd[0] & 0x01;
+    } else if (emu->controller == OLED_EMU_SSD1306) {
+        switch (cmd[0]) {
+        case 0x20:
+            emu->mode = cmd[1] & 0x03;
+            break;
+        case 0x21:
+            emu->colStart = cmd[1] & 0x7F;
+            emu->colEnd = cmd[2] & 0x7F;
+            emu->column = emu->colStart;
+            break;
+        case 0x22:
+            emu->pageStart = cmd[1] & 0x07;
+            emu->pageEnd = cmd[2] & 0x07;
+            emu->page = emu->pageStart;
+            break;
+        }
+    }
+}
+
+/*
+ * Function for writing one data byte into GRAM and advancing the address counters
+ */
+static void data(OledEmu *emu, uint8_t byte) {
+    if (emu->controller == OLED_EMU_SH1106) {
+        // page addressing only, the column stops at the end of the page
+        if (emu->column < OLED_EMU_COLUMNS) emu->gram[emu->page][emu->column++] = byte;
+        return;
+    }
+
+    if (emu->column < OLED_EMU_WIDTH) emu->gram[emu->page][emu->column] = byte;
+    switch (emu->mode) {
+    case 0: // horizontal, wraps within the 0x21/0x22 window
+        if (emu->column++ >= emu->colEnd) {
+            emu->column = emu->colStart;
+            emu->page = (emu->page >= emu->pageEnd) ? emu->pageStart : emu->page + 1;
+        }
+        break;
+    case 1: // vertical
+        if (emu->page++ >= emu->pageEnd) {
+            emu->page = emu->pageStart;
+            emu->column = (emu->column >= emu->colEnd) ? emu->colStart : emu->column + 1;
+        }
+        break;
+    default: // page, the column wraps within the page
+        if (++emu->column >= OLED_EMU_WIDTH) emu->column = 0;
+        break;
+    }
+}
+
+static uint8_t bus_start(void *ctx, uint8_t rw) {
+    OledEmu *emu = ctx;
+    if (rw == TWI_READ) return TWI_NACK;    // status read is not supported over I2C
+
+    emu->expectControl = 1;
+    emu->total.transactions++;
+    emu->frame.transactions++;
+    emu->total.bytes++;
+    emu->frame.bytes++;
+    return TWI_ACK;
+}
+
+static uint8_t bus_write(void *ctx, uint8_t byte) {
+    OledEmu *emu = ctx;
+
+    emu->total.bytes++;
+    emu->frame.bytes++;
+
+    if (emu->expectControl) {
+        emu->single = (byte & 0x80) != 0;
+        emu->dataMode = (byte & 0x40) != 0;
+        emu->expectControl = 0;
+        return TWI_ACK;
+    }
+
+    if (emu->dataMode) {
+        emu->total.dataBytes++;
+        emu->frame.dataBytes++;
+        data(emu, byte);
+    } else {
+        emu->total.commandBytes++;
+        emu->frame.commandBytes++;
+        emu->cmd[emu->cmdLen++] = byte;
+        if (emu->cmdLen >= command_length(emu, emu->cmd[0])) {
+            command(emu, emu->cmd);
+            emu->cmdLen = 0;
+        }
+    }
+    if (emu->single) emu->expectControl = 1;
+    return TWI_ACK;
+}
+
+static twi_host_device_t emu_device = {
+    .start = bus_start,
+    .write = bus_write,
+};
+
+void oled_emu_init(OledEmu *emu, uint8_t controller) {
+    memset(emu, 0, sizeof(*emu));
+    emu->controller = controller;
+    emu->mode = 2;                      // page addressing after reset
+    emu->colEnd = OLED_EMU_WIDTH - 1;
+    emu->pageEnd = OLED_EMU_PAGES - 1;
+    // GRAM is not cleared by a reset, make that visible in snapshots
+    memset(emu->gram, 0x55, sizeof(emu->gram));
+}
+
+void oled_emu_attach(OledEmu *emu, uint8_t addr) {
+    emu_device.ctx = emu;
+    twi_host_attach(addr, &emu_device);
+}
+
+OledEmuCounters oled_emu_frame(OledEmu *emu) {
+    OledEmuCounters frame = emu->frame;
+    memset(&emu->frame, 0, sizeof(emu->frame));
+    return frame;
+}
+
+uint8_t oled_emu_pixel(const OledEmu *emu, uint8_t x, uint8_t y) {
+    if (x >= OLED_EMU_WIDTH || y >= OLED_EMU_HEIGHT) return 0;
+    if (emu->controller == OLED_EMU_SH1106) x += 2;
+    return (emu->gram[y / 8][x] >> (y % 8)) & 0x01;
+}
+
+uint8_t oled_emu_write_pbm(const OledEmu *emu, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) return 1;
+
+    // lit pixels are written as 1 (black), so the text is dark on white
+    fprintf(f, "P1\n%d %d\n", OLED_EMU_WIDTH, OLED_EMU_HEIGHT);
+    for (uint8_t y = 0; y < OLED_EMU_HEIGHT; y++) {
+        for (uint8_t x = 0; x < OLED_EMU_WIDTH; x++) {
+            fputc(oled_emu_pixel(emu, x, y) ? '1' : '0', f);
+            if ((x & 0x3F) == 0x3F) fputc('\n', f);    // PBM lines up to 70 characters
+        }
+    }
+    return fclose(f) ? 1 : 0;
+}
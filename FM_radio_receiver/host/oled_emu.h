@@ -0,0 +1,96 @@
+ /**
+  * @file oled_emu.h
+  * @defgroup oled_emu OLED Controller Emulator <oled_emu.h>
+  * @code #include <oled_emu.h> @endcode
+  *
+  * @brief SH1106/SSD1306 display controller emulator for host builds
+  *
+  * The emulator is attached to the host TWI backend (twi_host.h) and parses
+  * what oled_command() and oled_data() send: control bytes (Co and D/C bits),
+  * page and column addressing (0xB0-0xB7, 0x00-0x1F, and on SSD1306 the
+  * memory mode 0x20 and the windows 0x21/0x22) and data written into the
+  * controller GRAM. Other commands are accepted with their argument bytes.
+  *
+  * Every byte and transaction the display receives is counted, the counters
+  * can be taken per frame and the visible GRAM can be saved as a PBM image.
+  * @{
+  */
+
+#ifndef OLED_EMU_H
+#define OLED_EMU_H
+
+#include <stdint.h>
+
+#define OLED_EMU_SH1106  0  // 132 x 64 GRAM, page addressing, panel shows columns 2-129
+#define OLED_EMU_SSD1306 1  // 128 x 64 GRAM, page/horizontal/vertical addressing
+
+#define OLED_EMU_COLUMNS 132
+#define OLED_EMU_PAGES   8
+#define OLED_EMU_WIDTH   128
+#define OLED_EMU_HEIGHT  64
+
+// bus traffic of the display
+typedef struct {
+    uint32_t transactions;  // address bytes with ACK
+    uint32_t bytes;         // all bytes, address and control bytes included
+    uint32_t dataBytes;     // bytes written into GRAM
+    uint32_t commandBytes;  // command and argument bytes
+} OledEmuCounters;
+
+typedef struct {
+    uint8_t controller;     // OLED_EMU_SH1106 or OLED_EMU_SSD1306
+    uint8_t gram[OLED_EMU_PAGES][OLED_EMU_COLUMNS];
+
+    // addressing
+    uint8_t page;
+    uint8_t column;
+    uint8_t mode;           // SSD1306 0x20: 0 horizontal, 1 vertical, 2 page
+    uint8_t colStart, colEnd;
+    uint8_t pageStart, pageEnd;
+    uint8_t displayOn;
+
+    // I2C stream parser
+    uint8_t expectControl;  // next byte is a control byte
+    uint8_t dataMode;       // D/C of the current byte(s)
+    uint8_t single;         // Co = 1, one byte then a new control byte
+    uint8_t cmd[8];         // command being collected with its arguments
+    uint8_t cmdLen;
+
+    OledEmuCounters total;  // since oled_emu_init()
+    OledEmuCounters frame;  // since the last oled_emu_frame()
+} OledEmu;
+
+/**
+ * @brief Puts the controller into its reset state
+ * @param emu        Emulator instance
+ * @param controller OLED_EMU_SH1106 or OLED_EMU_SSD1306
+ */
+void oled_emu_init(OledEmu *emu, uint8_t controller);
+
+/**
+ * @brief Connects the emulator to the host TWI bus
+ * @param emu  Emulator instance, only one can be attached at a time
+ * @param addr 7-bit I2C address, eg. OLED_I2C_ADR
+ */
+void oled_emu_attach(OledEmu *emu, uint8_t addr);
+
+/**
+ * @brief Returns the counters of the traffic since the previous call and restarts them
+ */
+OledEmuCounters oled_emu_frame(OledEmu *emu);
+
+/**
+ * @brief Returns one pixel of the visible panel
+ * @param x 0-127, y 0-63
+ */
+uint8_t oled_emu_pixel(const OledEmu *emu, uint8_t x, uint8_t y);
+
+/**
+ * @brief Saves the visible panel as a plain (P1) PBM image
+ * @return 0 on success, 1 if the file could not be written
+ */
+uint8_t oled_emu_write_pbm(const OledEmu *emu, const char *path);
+
+/** @} */
+
+#endif
@@ -0,0 +1,338 @@
+ /**
+  * @file si4703_sim.c
+  * @defgroup si4703_sim Si4703 Simulator <si4703_sim.c>
+  * @code #include <si4703_sim.h> @endcode
+  *
+  * @brief Behavioral model of the Si4703 tuner for host builds
+  */
+
+#include "si4703_sim.h"
+#include "si4703.h"
+#include "twi_host.h"
+#include "hal.h"
+#include <string.h>
+
+// register bits used by the model
+#define REG02_SKMODE  (1 << 10)
+#define REG02_SEEKUP  (1 << 9)
+#define REG02_SEEK    (1 << 8)
+#define REG02_ENABLE  (1 << 0)
+#define REG03_TUNE    (1 << 15)
+#define REG04_RDSIEN  (1 << 15)
+#define REG04_STCIEN  (1 << 14)
+#define REG04_RDS     (1 << 12)
+#define REG06_RDSM    (1 << 11)
+#define REG0A_RDSR    (1 << 15)
+#define REG0A_STC     (1 << 14)
+#define REG0A_SF      (1 << 13)
+#define REG0A_ST      (1 << 8)
+
+#define CHAN_MASK     0x03FF
+#define CHAN_MAX      ((FREQ_MAX - FREQ_MIN) / 10)  // EU band, 100 kHz spacing
+
+#define OP_NONE 0
+#define OP_TUNE 1
+#define OP_SEEK 2
+
+static Si4703Sim *attached;
+
+/*
+ * Function for finding the station on a channel, NULL for an empty channel
+ */
+static const SimStation *station_at(const Si4703Sim *sim, uint16_t channel) {
+    for (uint8_t i = 0; i < sim->stationCount; i++) {
+        if ((sim->stations[i].freq - FREQ_MIN) / 10 == channel) return &sim->stations[i];
+    }
+    return NULL;
+}
+
+static uint16_t read_channel(const Si4703Sim *sim) {
+    return sim->regs[0x0B] & CHAN_MASK;
+}
+
+/*
+ * Function for pulling GPIO2 low for one interrupt pulse, if it is configured as STC/RDS interrupt
+ */
+static void gpio2_pulse(Si4703Sim *sim, uint64_t now) {
+    if (sim->gpio2Pin == NULL || (sim->regs[0x04] & 0x000C) != 0x0004) return;
+    sim->pulseEndUs = now + SI4703_SIM_PULSE_US;
+    hal_set_pin(sim->gpio2Pin, sim->gpio2Bit, 0);
+}
+
+/*
+ * Function for moving to a channel, updates READCHAN, RSSI and stereo indicator
+ */
+static void set_channel(Si4703Sim *sim, uint16_t channel) {
+    const SimStation *station = station_at(sim, channel);
+    uint8_t rssi = station ? station->rssi : SI4703_SIM_NOISE_RSSI;
+
+    sim->regs[0x0B] = (sim->regs[0x0B] & ~CHAN_MASK) | channel;
+    sim->regs[0x0A] = (sim->regs[0x0A] & 0xFF00 & ~REG0A_ST) | rssi;
+    if (station) sim->regs[0x0A] |= REG0A_ST;
+}
+
+/*
+ * Function for ending a tune or seek operation with STC = 1
+ */
+static void op_complete(Si4703Sim *sim, uint64_t now, uint8_t failed) {
+    sim->op = OP_NONE;
+    sim->regs[0x0A] |= REG0A_STC;
+    if (failed) sim->regs[0x0A] |= REG0A_SF;
+    sim->stcCount++;
+    sim->stcUs = now;
+    if (sim->regs[0x04] & REG04_STCIEN) gpio2_pulse(sim, now);
+
+    // the RDS decoder of the chip synchronises to the new station first
+    sim->groupIndex = 0;
+    sim->groupRead = 1;
+    sim->nextGroupUs = now + sim->groupUs;
+}
+
+/*
+ * Function for doing one seek step, returns 1 when the seek ends
+ */
+static uint8_t seek_step(Si4703Sim *sim, uint64_t now) {
+    uint16_t channel = read_channel(sim);
+    uint8_t up = (sim->regs[0x02] & REG02_SEEKUP) != 0;
+
+    if (up ? channel >= CHAN_MAX : channel == 0) {
+        // SKMODE = 1 stops at the band limit, 0 wraps around
+        if (sim->regs[0x02] & REG02_SKMODE) {
+            op_complete(sim, now, 1);
+            return 1;
+        }
+        channel = up ? 0 : CHAN_MAX;
+    } else {
+        channel = up ? channel + 1 : channel - 1;
+    }
+    set_channel(sim, channel);
+
+    const SimStation *station = station_at(sim, channel);
+    if (station && station->rssi >= (sim->regs[0x05] >> 8)) {
+        op_complete(sim, now, 0);
+        return 1;
+    }
+    if (channel == sim->seekStart) {
+        op_complete(sim, now, 1);   // whole band searched
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Function for putting one 16-bit word of group data into RDSA-RDSD with a block error level
+ */
+static uint8_t put_block(Si4703Sim *sim, uint8_t block, uint16_t data) {
+    uint8_t bler = 0;
+
+    if (sim->blockErrorRate) {
+        // xorshift32, deterministic for a given seed
+        sim->seed ^= sim->seed << 13;
+        sim->seed ^= sim->seed >> 17;
+        sim->seed ^= sim->seed << 5;
+        if ((sim->seed & 0xFF) < sim->blockErrorRate) {
+            bler = 3;
+            data ^= (uint16_t)(sim->seed >> 8);
+        }
+    }
+    sim->regs[0x0C + block] = data;
+    return bler;
+}
+
+/*
+ * Function for generating the next RDS group of the tuned station
+ */
+static void next_group(Si4703Sim *sim, uint64_t now, const SimStation *station) {
+    uint16_t b, c, d;
+    uint32_t n = sim->groupIndex++;
+    uint8_t rtSegments = station->rt ? (strlen(station->rt) + 3) / 4 : 0;
+
+    if (rtSegments > 16) rtSegments = 16;
+
+    if (n % SI4703_SIM_CT_GROUPS == 0) {
+        // 4A clock-time, UTC with zero local offset
+        uint16_t minutes = (sim->hour * 60 + sim->minute + n / SI4703_SIM_CT_GROUPS) % (24 * 60);
+        b = (4 << 12) | (station->pty << 5);
+        c = (minutes / 60) >> 4;
+        d = ((minutes / 60) & 0x0F) << 12 | (minutes % 60) << 6;
+    } else if (rtSegments && (n & 1)) {
+        // 2A RadioText, text shorter than 64 characters ends with a carriage return
+        uint8_t seg = (n >> 1) % rtSegments;
+        char chars[4];
+        for (uint8_t i = 0; i < 4; i++) {
+            uint8_t pos = 4*seg + i;
+            size_t len = strlen(station->rt);
+            chars[i] = pos < len ? station->rt[pos] : (pos == len ? '\r' : ' ');
+        }
+        b = (2 << 12) | (station->pty << 5) | seg;
+        c = (chars[0] << 8) | chars[1];
+        d = (chars[2] << 8) | chars[3];
+    } else {
+        // 0A programme service name
+        uint8_t seg = (n >> 1) & 0x03;
+        b = (0 << 12) | (1 << 10) | (station->pty << 5) | seg;
+        c = 0xE0CD;
+        d = (station->ps[2*seg] << 8) | station->ps[2*seg + 1];
+    }
+
+    if (!sim->groupRead) sim->groupsMissed++;
+
+    uint8_t blerA = put_block(sim, 0, station->pi);
+    uint8_t blerB = put_block(sim, 1, b);
+    uint8_t blerC = put_block(sim, 2, c);
+    uint8_t blerD = put_block(sim, 3, d);
+
+    // BLERA-BLERD are reported in verbose mode only
+    if (!(sim->regs[0x06] & REG06_RDSM)) blerA = blerB = blerC = blerD = 0;
+    sim->regs[0x0A] = (sim->regs[0x0A] & ~(0x03 << 9)) | REG0A_RDSR | (blerA << 9);
+    sim->regs[0x0B] = (sim->regs[0x0B] & CHAN_MASK) | (blerB << 14) | (blerC << 12) | (blerD << 10);
+
+    sim->groupRead = 0;
+    sim->groupsSent++;
+    sim->rdsrEndUs = now + SI4703_SIM_RDSR_US;
+    if (sim->regs[0x04] & REG04_RDSIEN) gpio2_pulse(sim, now);
+}
+
+/*
+ * Function for advancing the model to the current virtual time
+ */
+static void sim_update(Si4703Sim *sim, uint64_t now) {
+    if (sim->pulseEndUs && now >= sim->pulseEndUs) {
+        sim->pulseEndUs = 0;
+        hal_set_pin(sim->gpio2Pin, sim->gpio2Bit, 1);
+    }
+
+    if (sim->op == OP_TUNE && now >= sim->opNextUs) {
+        op_complete(sim, sim->opNextUs, 0);
+    }
+    while (sim->op == OP_SEEK && now >= sim->opNextUs) {
+        if (seek_step(sim, sim->opNextUs)) break;
+        sim->opNextUs += sim->seekStepUs;
+    }
+
+    if ((sim->regs[0x0A] & REG0A_RDSR) && now >= sim->rdsrEndUs) {
+        sim->regs[0x0A] &= ~REG0A_RDSR;
+    }
+
+    const SimStation *station = station_at(sim, read_channel(sim));
+    uint8_t receiving = sim->op == OP_NONE && (sim->regs[0x02] & REG02_ENABLE) &&
+                        (sim->regs[0x04] & REG04_RDS) && station && station->ps;
+    while (receiving && sim->nextGroupUs && now >= sim->nextGroupUs) {
+        // schedule first, the GPIO2 interrupt may read the group and update the model again
+        uint64_t at = sim->nextGroupUs;
+        sim->nextGroupUs += sim->groupUs;
+        next_group(sim, at, station);
+    }
+}
+
+/*
+ * Function for reacting to a register written by the host
+ */
+static void reg_written(Si4703Sim *sim, uint8_t reg, uint16_t old) {
+    uint64_t now = hal_micros();
+    uint16_t val = sim->regs[reg];
+
+    if (reg == 0x03 && (val & REG03_TUNE) && !(old & REG03_TUNE)) {
+        sim->op = OP_TUNE;
+        sim->opNextUs = now + sim->tuneUs;
+        sim->tuneCount++;
+        sim->nextGroupUs = 0;
+        sim->regs[0x0A] &= ~(REG0A_RDSR | REG0A_SF);
+        set_channel(sim, val & CHAN_MASK);
+    } else if (reg == 0x02 && (val & REG02_SEEK) && !(old & REG02_SEEK)) {
+        sim->op = OP_SEEK;
+        sim->opNextUs = now + sim->seekStepUs;
+        sim->seekStart = read_channel(sim);
+        sim->nextGroupUs = 0;
+        sim->regs[0x0A] &= ~(REG0A_RDSR | REG0A_SF);
+    }
+
+    // clearing TUNE and SEEK ends the operation and clears STC and SF
+    if ((reg == 0x02 || reg == 0x03) &&
+        !(sim->regs[0x02] & REG02_SEEK) && !(sim->regs[0x03] & REG03_TUNE)) {
+        if (sim->op != OP_NONE) {
+            sim->op = OP_NONE;
+            sim->nextGroupUs = now + sim->groupUs;
+        }
+        sim->regs[0x0A] &= ~(REG0A_STC | REG0A_SF);
+    }
+}
+
+static uint8_t bus_start(void *ctx, uint8_t rw) {
+    Si4703Sim *sim = ctx;
+    sim->reading = rw;
+    sim->bytePos = 0;
+    sim_update(sim, hal_micros());
+    return TWI_ACK;
+}
+
+static uint8_t bus_write(void *ctx, uint8_t data) {
+    Si4703Sim *sim = ctx;
+    uint8_t reg = (0x02 + sim->bytePos / 2) & 0x0F;
+
+    // 0x0A-0x0F and 0x00-0x01 are read-only, the bytes are still acknowledged
+    if ((sim->bytePos & 1) == 0) {
+        sim->upper = data;
+    } else if (reg >= 0x02 && reg <= 0x09) {
+        uint16_t old = sim->regs[reg];
+        sim->regs[reg] = (sim->upper << 8) | data;
+        reg_written(sim, reg, old);
+    }
+    sim->bytePos++;
+    return TWI_ACK;
+}
+
+static uint8_t bus_read(void *ctx, uint8_t ack) {
+    Si4703Sim *sim = ctx;
+    uint8_t reg = (0x0A + sim->bytePos / 2) & 0x0F;
+    uint8_t data = (sim->bytePos & 1) ? sim->regs[reg] & 0xFF : sim->regs[reg] >> 8;
+
+    // lower byte of RDSD read, the host has the whole group
+    if (reg == 0x0F && (sim->bytePos & 1) && (sim->regs[0x0A] & REG0A_RDSR) && !sim->groupRead) {
+        sim->groupRead = 1;
+        sim->groupsRead++;
+    }
+    sim->bytePos++;
+    (void)ack;
+    return data;
+}
+
+static void time_hook(uint64_t now_us) {
+    if (attached) sim_update(attached, now_us);
+}
+
+static twi_host_device_t sim_device = {
+    .start = bus_start,
+    .write = bus_write,
+    .read = bus_read,
+};
+
+void si4703_sim_init(Si4703Sim *sim, const SimStation *stations, uint8_t count) {
+    memset(sim, 0, sizeof(*sim));
+    sim->stations = stations;
+    sim->stationCount = count;
+    sim->tuneUs = SI4703_SIM_TUNE_US;
+    sim->seekStepUs = SI4703_SIM_SEEK_STEP_US;
+    sim->groupUs = SI4703_SIM_GROUP_US;
+    sim->seed = 1;
+    sim->hour = 12;
+    sim->groupRead = 1;
+
+    // reset values of DEVICEID, CHIPID and TEST1
+    sim->regs[0x00] = 0x1242;
+    sim->regs[0x01] = 0x1253;
+    sim->regs[0x07] = 0x0100;
+    set_channel(sim, 0);
+}
+
+void si4703_sim_attach(Si4703Sim *sim) {
+    attached = sim;
+    sim_device.ctx = sim;
+    twi_host_attach(SI4703_ADDR, &sim_device);
+    hal_set_time_hook(time_hook);
+    if (sim->gpio2Pin) hal_set_pin(sim->gpio2Pin, sim->gpio2Bit, 1);
+}
+
+uint16_t si4703_sim_get_freq(const Si4703Sim *sim) {
+    return read_channel(sim) * 10 + FREQ_MIN;
+}
@@ -0,0 +1,105 @@
+ /**
+  * @file si4703_sim.h
+  * @defgroup si4703_sim Si4703 Simulator <si4703_sim.h>
+  * @code #include <si4703_sim.h> @endcode
+  *
+  * @brief Behavioral model of the Si4703 tuner for host builds
+  *
+  * The model is attached to the host TWI backend (twi_host.h) at SI4703_ADDR
+  * and answers the real driver si4703.c:
+  *  - register file 0x00-0x0F, writes start at 0x02, reads start at 0x0A
+  *    and wrap around, upper byte first,
+  *  - TUNE and SEEK with STC/SF after a configurable time, seek steps over
+  *    a synthetic band of stations and honours SEEKTH, SEEKUP and SKMODE,
+  *  - RDS groups 0A, 2A and 4A generated every 87.6 ms on a station that
+  *    has a PS name, with RDSR, verbose mode BLERA-BLERD and a seeded
+  *    pseudo-random block error rate,
+  *  - GPIO2 STC/RDS pulses raising the pin change interrupt of the MCU.
+  *
+  * Time is the virtual clock of the HAL, so every run is deterministic.
+  * @{
+  */
+
+#ifndef SI4703_SIM_H
+#define SI4703_SIM_H
+
+#include <stdint.h>
+
+// Default timing, datasheet maximums
+#define SI4703_SIM_TUNE_US      60000UL // TUNE to STC
+#define SI4703_SIM_SEEK_STEP_US 60000UL // seek time per channel
+#define SI4703_SIM_GROUP_US     87600UL // one RDS group, 104 bits at 1187.5 bit/s
+#define SI4703_SIM_RDSR_US      40000UL // RDSR stays set after a new group
+#define SI4703_SIM_PULSE_US     5000UL  // GPIO2 interrupt pulse width
+#define SI4703_SIM_CT_GROUPS    685     // groups between clock-time groups, about a minute
+
+#define SI4703_SIM_NOISE_RSSI   8       // RSSI of a channel without a station
+
+// one station of the synthetic band
+typedef struct {
+    uint16_t freq;      // MHz multiplied by 100
+    uint8_t rssi;       // 0-127
+    uint16_t pi;        // RDS programme identification
+    uint8_t pty;        // RDS programme type
+    const char *ps;     // programme service name, NULL for a station without RDS
+    const char *rt;     // RadioText up to 64 characters, may be NULL
+} SimStation;
+
+typedef struct {
+    // configuration, set by si4703_sim_init() and may be changed before the run
+    const SimStation *stations;
+    uint8_t stationCount;
+    uint32_t tuneUs;
+    uint32_t seekStepUs;
+    uint32_t groupUs;
+    uint8_t blockErrorRate;     // probability of an uncorrectable block, n/256
+    uint32_t seed;              // seed of the block error generator
+    uint8_t hour, minute;       // UTC time sent in the first clock-time group
+    volatile uint8_t *gpio2Pin; // input register GPIO2 is wired to, NULL if not wired
+    uint8_t gpio2Bit;
+
+    // chip state
+    uint16_t regs[16];
+    uint8_t op;                 // running TUNE or SEEK
+    uint64_t opNextUs;          // end of the tune or the next seek step
+    uint16_t seekStart;         // channel the seek started from
+    uint64_t pulseEndUs;        // GPIO2 goes high again, 0 if not pulsing
+    uint64_t nextGroupUs;       // arrival of the next RDS group, 0 if not receiving
+    uint64_t rdsrEndUs;         // RDSR is cleared
+    uint32_t groupIndex;        // position in the group sequence of the station
+    uint8_t groupRead;          // current group has been read by the host
+    uint8_t bytePos;            // byte index within the running transaction
+    uint8_t reading;            // running transaction reads
+    uint8_t upper;              // upper byte of the register being written
+
+    // statistics
+    uint32_t groupsSent;        // groups put into RDSA-RDSD
+    uint32_t groupsRead;        // groups read at least once by the host
+    uint32_t groupsMissed;      // groups replaced before the host read them
+    uint32_t stcCount;          // tune/seek operations completed
+    uint32_t tuneCount;         // tune operations started
+    uint64_t stcUs;             // time STC was set last
+} Si4703Sim;
+
+/**
+ * @brief Puts the model into its reset state with the default timing
+ * @param sim      Model instance
+ * @param stations Synthetic band, sorted or not
+ * @param count    Number of stations
+ */
+void si4703_sim_init(Si4703Sim *sim, const SimStation *stations, uint8_t count);
+
+/**
+ * @brief Connects the model to the host TWI bus and to the virtual clock
+ * @param sim Model instance, only one model can be attached at a time
+ */
+void si4703_sim_attach(Si4703Sim *sim);
+
+/**
+ * @brief Returns the frequency the model is tuned to (MHz multiplied by 100)
+ */
+uint16_t si4703_sim_get_freq(const Si4703Sim *sim);
+
+/** @} */
+
+#endif
@@ -66,19 +66,19 @@
 /** @brief Stop timer, prescaler 000 --> STOP */
 #define tim0_stop() TCCR0B &= ~((1<<CS02) | (1<<CS01) | (1<<CS00));
 
-/** @brief Set overflow 4ms, prescaler 001 --> 1 */
-#define tim0_ovf_4ms() TCCR1B &= ~((1<<CS12) | (1<<CS11)); TCCR1B |= (1<<CS10);
+/** @brief Set overflow 16us, prescaler 001 --> 1 */
+#define tim0_ovf_16us() TCCR0B &= ~((1<<CS02) | (1<<CS01)); TCCR0B |= (1<<CS00);
 
-/** @brief Set overflow 33ms, prescaler 010 --> 8 */
-#define tim0_ovf_33ms() TCCR1B &= ~((1<<CS12) | (1<<CS10)); TCCR1B |= (1<<CS11);
+/** @brief Set overflow 128us, prescaler 010 --> 8 */
+#define tim0_ovf_128us() TCCR0B &= ~((1<<CS02) | (1<<CS00)); TCCR0B |= (1<<CS01);
 
-/** @brief Set overflow 262ms, prescaler 011 --> 64 */
-#define tim0_ovf_262ms() TCCR1B &= ~(1<<CS12); TCCR1B |= (1<<CS11) | (1<<CS10);
+/** @brief Set overflow 1ms, prescaler 011 --> 64 */
+#define tim0_ovf_1ms() TCCR0B &= ~(1<<CS02); TCCR0B |= (1<<CS01) | (1<<CS00);
 
-/** @brief Set overflow 1s, prescaler 100 --> 256 */
-#define tim0_ovf_1sec() TCCR1B &= ~((1<<CS11) | (1<<CS10)); TCCR1B |= (1<<CS12);
+/** @brief Set overflow 4ms, prescaler 100 --> 256 */
+#define tim0_ovf_4ms() TCCR0B &= ~((1<<CS01) | (1<<CS00)); TCCR0B |= (1<<CS02);
 
-/** @brief Set overflow 4s, prescaler // 101 --> 1024 */
+/** @brief Set overflow 16ms, prescaler 101 --> 1024 */
 #define tim0_ovf_16ms() TCCR0B &= ~(1<<CS01); TCCR0B |= (1<<CS02) | (1<<CS00);
 
 /** @brief Enable overflow interrupt, 1 --> enable */
@@ -0,0 +1,206 @@
+ /**
+  * @file bandscan.c
+  * @defgroup bandscan Band Scan <bandscan.c>
+  * @code #include <bandscan.h> @endcode
+  *
+  * @brief Non-blocking scan of the FM band built on the Si4703 library
+  */
+
+#include <string.h>
+#include "hal.h"
+#include "bandscan.h"
+
+// scan state machine
+#define ST_IDLE         0   // no scan
+#define ST_STOP         1   // waiting for the operation running before the scan to end
+#define ST_WAIT_TUNE    2   // tune or seek running
+#define ST_DWELL        3   // tuned, waiting before the RSSI reading
+#define ST_WAIT_PI      4   // station found, waiting for its PI code
+#define ST_RESTORE      5   // tuning back the frequency from before the scan
+
+static uint8_t state = ST_IDLE;
+static uint8_t scanMode;
+static uint16_t dwellMs;
+static uint16_t piMs;
+static RdsInfo *scanRds;
+
+static uint8_t channels[SCAN_CHANNELS];    // SCAN_RSSI() | SCAN_STEREO per channel
+static ScanStation stations[SCAN_MAX_STATIONS];
+static uint8_t stationCount;
+
+static uint8_t channel;             // channel being measured
+static uint8_t seekRunning;         // ST_WAIT_TUNE waits for a seek, not a tune
+static uint8_t cancelled;
+static uint16_t restoreFreq;        // frequency tuned before the scan
+static uint32_t startMs;            // hal_millis() at scan_start()
+static uint32_t stateMs;            // hal_millis() when the current state began
+static uint32_t scanTime;           // duration of the last scan
+
+/*
+ * Function for adding a station to the list, the list stays sorted by RSSI
+ * and the weakest station drops out of a full list
+ */
+static void add_station(uint8_t rssi, uint8_t stereo, uint16_t pi) {
+    uint8_t i = (stationCount < SCAN_MAX_STATIONS) ? stationCount++ : SCAN_MAX_STATIONS;
+
+    while (i > 0 && stations[i - 1].rssi < rssi) {
+        if (i < SCAN_MAX_STATIONS) stations[i] = stations[i - 1];
+        i--;
+    }
+    if (i < SCAN_MAX_STATIONS) {
+        stations[i].channel = channel;
+        stations[i].rssi = rssi;
+        stations[i].stereo = stereo;
+        stations[i].pi = pi;
+    }
+}
+
+/*
+ * Function for ending the scan on the frequency tuned before it
+ */
+static void finish(void) {
+    si4703_tune_start(restoreFreq);
+    state = ST_RESTORE;
+}
+
+/*
+ * Function for moving to the next channel or to the end of the scan
+ */
+static void next_channel(void) {
+    if (scanMode == SCAN_SEEK) {
+        si4703_seek_start(SEEK_UP);
+        seekRunning = 1;
+        state = ST_WAIT_TUNE;
+    } else if (channel < SCAN_CHANNELS - 1) {
+        si4703_tune_start(FREQ_MIN + (++channel) * 10);
+        state = ST_WAIT_TUNE;
+    } else {
+        finish();
+    }
+}
+
+/*
+ * Function for reading the signal of the tuned channel
+ */
+static void measure(void) {
+    uint8_t rssi = si4703_get_rssi();
+    uint8_t stereo = si4703_get_stereo();
+
+    if (rssi > SCAN_RSSI(0xFF)) rssi = SCAN_RSSI(0xFF);
+    channels[channel] = rssi | (stereo ? SCAN_STEREO : 0);
+
+    if (rssi < SCAN_RSSI_MIN) {
+        next_channel();
+    } else if (piMs && scanRds) {
+        // rds_clear() marks every field updated, the PI bit is waited for
+        rds_clear(scanRds);
+        scanRds->updated &= ~RDS_UPD_PI;
+        stateMs = hal_millis();
+        state = ST_WAIT_PI;
+    } else {
+        add_station(rssi, stereo, 0);
+        next_channel();
+    }
+}
+
+void scan_start(uint8_t mode, uint16_t dwell_ms, uint16_t pi_ms, RdsInfo *rds) {
+    scanMode = mode;
+    dwellMs = dwell_ms;
+    piMs = pi_ms;
+    scanRds = rds;
+
+    memset(channels, 0, sizeof(channels));
+    stationCount = 0;
+    channel = 0;
+    seekRunning = 0;
+    cancelled = 0;
+    // a knob turn not yet tuned counts, si4703_cancel() drops it
+    restoreFreq = si4703_get_target_freq();
+    startMs = hal_millis();
+
+    // a running tune or seek ends in the following polls
+    si4703_cancel();
+    state = ST_STOP;
+}
+
+ScanStatus scan_poll(void) {
+    Si4703Status status;
+
+    if (state == ST_IDLE) return SCAN_IDLE;
+
+    if (cancelled && state != ST_RESTORE) {
+        if (si4703_poll() == SI4703_BUSY) return SCAN_BUSY;
+        finish();
+        return SCAN_BUSY;
+    }
+
+    switch (state) {
+    case ST_STOP:
+        if (si4703_poll() == SI4703_BUSY) break;
+        // both modes start on the lowest channel, a seek up cannot stop on it
+        si4703_tune_start(FREQ_MIN);
+        state = ST_WAIT_TUNE;
+        break;
+
+    case ST_WAIT_TUNE:
+        status = si4703_poll();
+        if (status == SI4703_BUSY) break;
+
+        if (seekRunning) {
+            // the seek wraps at the band end, a channel below the last one means the band is done
+            uint8_t found = (si4703_get_tuning_freq() - FREQ_MIN) / 10;
+            if (status != SI4703_DONE || found <= channel) {
+                finish();
+                break;
+            }
+            channel = found;
+        }
+        stateMs = hal_millis();
+        state = ST_DWELL;
+        break;
+
+    case ST_DWELL:
+        if (hal_millis() - stateMs >= dwellMs) measure();
+        break;
+
+    case ST_WAIT_PI:
+        if (scanRds->updated & RDS_UPD_PI) {
+            add_station(SCAN_RSSI(channels[channel]), channels[channel] & SCAN_STEREO ? 1 : 0, scanRds->pi);
+            next_channel();
+        } else if (hal_millis() - stateMs >= piMs) {
+            add_station(SCAN_RSSI(channels[channel]), channels[channel] & SCAN_STEREO ? 1 : 0, 0);
+            next_channel();
+        }
+        break;
+
+    case ST_RESTORE:
+        if (si4703_poll() == SI4703_BUSY) break;
+        scanTime = hal_millis() - startMs;
+        state = ST_IDLE;
+        return cancelled ? SCAN_CANCELLED : SCAN_DONE;
+    }
+    return SCAN_BUSY;
+}
+
+void scan_cancel(void) {
+    if (state == ST_IDLE || state == ST_RESTORE) return;
+    cancelled = 1;
+    si4703_cancel();
+}
+
+uint8_t scan_get_stations(const ScanStation **list) {
+    *list = stations;
+    return stationCount;
+}
+
+uint8_t scan_get_channel(uint8_t ch) {
+    return (ch < SCAN_CHANNELS) ? channels[ch] : 0;
+}
+
+uint8_t scan_get_progress(void) {
+    return channel;
+}
+
+uint32_t scan_get_time_ms(void) {
+    return scanTime;
+}
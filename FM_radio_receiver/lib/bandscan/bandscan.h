@@ -0,0 +1,111 @@
+ /**
+  * @file bandscan.h
+  * @defgroup bandscan Band Scan <bandscan.h>
+  * @code #include <bandscan.h> @endcode
+  *
+  * @brief Non-blocking scan of the FM band built on the Si4703 library
+  *
+  * A scan measures RSSI and the stereo indicator of the band channels into
+  * a table of one byte per channel and collects the stations (RSSI at least
+  * SCAN_RSSI_MIN) with their PI code into a list sorted by RSSI, strongest
+  * first. Two modes are available:
+  *  - SCAN_FULL tunes every one of the 206 EU channels, so the table holds
+  *    the whole spectrum,
+  *  - SCAN_SEEK lets the chip seek from station to station and measures
+  *    only the channels it stops at.
+  *
+  * scan_poll() advances the scan and has to be called every SI4703_POLL_MS
+  * instead of si4703_poll() while the scan runs. The PI code is taken from
+  * the RdsInfo structure the application decodes with si4703_update_rds(),
+  * the scan clears it on every station. When the scan ends or is cancelled
+  * the frequency tuned or requested before the scan is restored.
+  * @{
+  */
+
+#ifndef BANDSCAN_H
+#define BANDSCAN_H
+
+#include <stdint.h>
+#include "rds.h"
+#include "si4703.h"
+
+#define SCAN_CHANNELS     ((FREQ_MAX - FREQ_MIN) / 10 + 1)  // 206 channels of 100 kHz
+
+#ifndef SCAN_MAX_STATIONS
+#define SCAN_MAX_STATIONS 16    // strongest stations kept in the list
+#endif
+#ifndef SCAN_RSSI_MIN
+#define SCAN_RSSI_MIN     15    // RSSI of a channel counted as a station
+#endif
+#define SCAN_DWELL_MS     20    // default wait between STC and the RSSI reading
+#define SCAN_PI_MS        300   // default wait for the PI code on a station
+
+// Scan modes
+#define SCAN_FULL 0
+#define SCAN_SEEK 1
+
+// Channel table byte: RSSI in the low 7 bits and the stereo indicator
+#define SCAN_RSSI(_ch)    ((_ch) & 0x7F)
+#define SCAN_STEREO       0x80
+
+typedef struct {
+    uint8_t channel;    // (frequency - FREQ_MIN) / 10
+    uint8_t rssi;
+    uint8_t stereo;
+    uint16_t pi;        // 0 when no PI was received in time
+} ScanStation;
+
+typedef enum {
+    SCAN_IDLE,          // no scan running, nothing to report
+    SCAN_BUSY,          // scan in progress
+    SCAN_DONE,          // scan finished, the results are complete
+    SCAN_CANCELLED      // scan stopped by scan_cancel(), the results are partial
+} ScanStatus;
+
+/**
+ * @brief Starts a scan, stops a running tune or seek first
+ * @param mode     SCAN_FULL or SCAN_SEEK
+ * @param dwell_ms wait between the end of a tune and the RSSI reading (eg. SCAN_DWELL_MS)
+ * @param pi_ms    longest wait for the PI code of a station, 0 skips PI (eg. SCAN_PI_MS)
+ * @param rds      RDS data decoded by the application, NULL skips PI
+ */
+void scan_start(uint8_t mode, uint16_t dwell_ms, uint16_t pi_ms, RdsInfo *rds);
+
+/**
+ * @brief Advances a running scan
+ * @return SCAN_BUSY while running, the final status once when the scan
+ *         ends and SCAN_IDLE afterwards.
+ */
+ScanStatus scan_poll(void);
+
+/**
+ * @brief Stops the running scan, scan_poll() reports SCAN_CANCELLED when the frequency is restored
+ */
+void scan_cancel(void);
+
+/**
+ * @brief Returns the station list sorted by RSSI, strongest first
+ * @param stations set to the first entry of the list
+ * @return number of stations
+ */
+uint8_t scan_get_stations(const ScanStation **stations);
+
+/**
+ * @brief Returns the table byte of a channel, 0 when it was not measured
+ * @param channel (frequency - FREQ_MIN) / 10
+ */
+uint8_t scan_get_channel(uint8_t channel);
+
+/**
+ * @brief Returns the channel the scan is measuring, for a progress display
+ */
+uint8_t scan_get_progress(void);
+
+/**
+ * @brief Returns the duration of the last finished scan in ms
+ */
+uint32_t scan_get_time_ms(void);
+
+/** @} */
+
+#endif
@@ -0,0 +1,111 @@
+ /**
+  * @file debounce.c
+  * @defgroup debounce Button Debouncer <debounce.c>
+  * @code #include <debounce.h> @endcode
+  *
+  * @brief Interrupt-driven debouncer of active-low buttons with an event queue
+  */
+
+#include "debounce.h"
+#include "gpio.h"
+
+#define SAMPLE_MASK  ((1 << DEBOUNCE_SAMPLES) - 1)
+#define LONG_TICKS   (DEBOUNCE_LONG_MS / DEBOUNCE_TICK_MS)
+#define REPEAT_TICKS (DEBOUNCE_REPEAT_MS / DEBOUNCE_TICK_MS)
+
+static uint8_t history[DEBOUNCE_BUTTONS];   // last samples, bit 0 is the newest, 1 = closed
+static uint8_t heldTicks[DEBOUNCE_BUTTONS]; // ticks since the press or the last repeat
+static volatile uint8_t pressed;            // debounced state, one bit per button
+static uint8_t longPressed;                 // buttons held past DEBOUNCE_LONG_MS
+
+// written by debounce_tick() only, read by debounce_get_event() only
+static volatile uint8_t queue[DEBOUNCE_QUEUE];
+static volatile uint8_t queueHead;
+static volatile uint8_t queueTail;
+static volatile uint16_t dropped;
+
+/*
+ * Function for queueing an event from the timer interrupt
+ */
+static void push(uint8_t event) {
+    uint8_t next = (queueHead + 1) & (DEBOUNCE_QUEUE - 1);
+    if (next == queueTail) {
+        dropped++;
+        return;
+    }
+    queue[queueHead] = event;
+    queueHead = next;
+}
+
+/*
+ * Function for setting up the button pins
+ */
+void debounce_init(void) {
+    for (uint8_t i = 0; i < DEBOUNCE_BUTTONS; i++) {
+        gpio_mode_input_pullup(&DEBOUNCE_DDR, DEBOUNCE_FIRST_PIN + i);
+        history[i] = 0;
+        heldTicks[i] = 0;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pressed = 0;
+        longPressed = 0;
+        queueHead = 0;
+        queueTail = 0;
+        dropped = 0;
+    }
+}
+
+/*
+ * Function for sampling the buttons, one port read for all of them
+ */
+void debounce_tick(void) {
+    uint8_t closed = (uint8_t)~DEBOUNCE_PINREG >> DEBOUNCE_FIRST_PIN;
+
+    for (uint8_t i = 0; i < DEBOUNCE_BUTTONS; i++) {
+        uint8_t bit = 1 << i;
+        uint8_t samples = (history[i] << 1) | ((closed >> i) & 0x01);
+        history[i] = samples;
+
+        if (!(pressed & bit)) {
+            if ((samples & SAMPLE_MASK) == SAMPLE_MASK) {
+                pressed |= bit;
+                longPressed &= ~bit;
+                heldTicks[i] = 0;
+                push(DEBOUNCE_EVENT(i, DEBOUNCE_PRESS));
+            }
+        } else if ((samples & SAMPLE_MASK) == 0) {
+            pressed &= ~bit;
+            push(DEBOUNCE_EVENT(i, DEBOUNCE_RELEASE));
+        } else if (++heldTicks[i] >= LONG_TICKS) {
+            // the first event is the long press, the next ones repeats
+            push(DEBOUNCE_EVENT(i, (longPressed & bit) ? DEBOUNCE_REPEAT : DEBOUNCE_LONG));
+            longPressed |= bit;
+            heldTicks[i] = LONG_TICKS - REPEAT_TICKS;
+        }
+    }
+}
+
+/*
+ * Function for taking the oldest event, the indices are single bytes so no
+ * interrupt lock is needed
+ */
+uint8_t debounce_get_event(void) {
+    uint8_t tail = queueTail;
+    if (tail == queueHead) return DEBOUNCE_NONE;
+
+    uint8_t event = queue[tail];
+    queueTail = (tail + 1) & (DEBOUNCE_QUEUE - 1);
+    return event;
+}
+
+uint8_t debounce_is_pressed(uint8_t button) {
+    return (pressed >> button) & 0x01;
+}
+
+uint16_t debounce_get_dropped(void) {
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = dropped;
+    }
+    return count;
+}
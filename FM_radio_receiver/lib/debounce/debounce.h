@@ -0,0 +1,88 @@
+ /**
+  * @file debounce.h
+  * @defgroup debounce Button Debouncer <debounce.h>
+  * @code #include <debounce.h> @endcode
+  *
+  * @brief Interrupt-driven debouncer of active-low buttons with an event queue
+  *
+  * debounce_tick() is called from a periodic timer interrupt (Timer0
+  * overflow, every DEBOUNCE_TICK_MS). It samples up to 8 neighbouring pins
+  * of one port into a shift register per button; a button changes its state
+  * only when the last DEBOUNCE_SAMPLES samples agree. State changes become
+  * events in a queue which the main loop empties with debounce_get_event(),
+  * so no code path waits for a contact to settle or to be released.
+  *
+  * Events of a held button: DEBOUNCE_PRESS, DEBOUNCE_LONG after
+  * DEBOUNCE_LONG_MS, then DEBOUNCE_REPEAT every DEBOUNCE_REPEAT_MS, and
+  * DEBOUNCE_RELEASE when it is let go.
+  * @{
+  */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include "hal.h"
+
+// Buttons on DEBOUNCE_FIRST_PIN .. DEBOUNCE_FIRST_PIN + DEBOUNCE_BUTTONS - 1, closed = low
+#ifndef DEBOUNCE_PINREG
+#define DEBOUNCE_DDR       DDRD
+#define DEBOUNCE_PINREG    PIND
+#define DEBOUNCE_FIRST_PIN PD4
+#define DEBOUNCE_BUTTONS   4        // PD4 encoder switch, PD5 mute, PD6 seek down, PD7 seek up
+#endif
+
+#define DEBOUNCE_TICK_MS   4        // period of debounce_tick() calls
+#define DEBOUNCE_SAMPLES   4        // equal samples for a state change (16 ms)
+#define DEBOUNCE_LONG_MS   1000     // hold time of a long press
+#define DEBOUNCE_REPEAT_MS 200      // repeat period after a long press
+
+// Number of queued events, power of 2
+#ifndef DEBOUNCE_QUEUE
+#define DEBOUNCE_QUEUE 8
+#endif
+
+// Event types
+#define DEBOUNCE_NONE    0
+#define DEBOUNCE_PRESS   1
+#define DEBOUNCE_RELEASE 2
+#define DEBOUNCE_LONG    3
+#define DEBOUNCE_REPEAT  4
+
+// An event holds the button index (0 = DEBOUNCE_FIRST_PIN) and its type
+#define DEBOUNCE_EVENT(button, type) (uint8_t)(((button) << 4) | (type))
+#define DEBOUNCE_BUTTON(event)       ((event) >> 4)
+#define DEBOUNCE_TYPE(event)         ((event) & 0x0F)
+
+/**
+ * @brief Sets the button pins as inputs with pull-ups and empties the queue
+ */
+void debounce_init(void);
+
+/**
+ * @brief Samples the buttons and queues their events
+ * @note Call it from a timer interrupt every DEBOUNCE_TICK_MS.
+ */
+void debounce_tick(void);
+
+/**
+ * @brief Takes the oldest event from the queue
+ * @return event made by DEBOUNCE_EVENT(), DEBOUNCE_NONE if the queue is empty
+ */
+uint8_t debounce_get_event(void);
+
+/**
+ * @brief Debounced state of a button
+ * @param button button index, 0 = DEBOUNCE_FIRST_PIN
+ * @return 1 if the button is held, 0 if released
+ */
+uint8_t debounce_is_pressed(uint8_t button);
+
+/**
+ * @brief Number of events lost because the queue was full
+ */
+uint16_t debounce_get_dropped(void);
+
+/** @} */
+
+#endif
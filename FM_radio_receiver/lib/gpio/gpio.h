@@ -24,7 +24,7 @@
  */
 
 // -- Includes -------------------------------------------------------
-#include <avr/io.h>
+#include <hal.h>
 
 
 // -- Function prototypes --------------------------------------------
@@ -0,0 +1,172 @@
+ /**
+  * @file hal.c
+  * @defgroup hal Hardware Abstraction Layer <hal.c>
+  * @code #include <hal.h> @endcode
+  *
+  * @brief Time source for AVR and the register file, interrupts and virtual clock of host builds
+  */
+
+#include "hal.h"
+
+#if defined(__AVR__)
+
+static volatile uint32_t millis;    // advanced by hal_tick()
+
+/*
+ * Function for advancing the time source from a timer interrupt
+ */
+void hal_tick(uint8_t ms) {
+    millis += ms;
+}
+
+/*
+ * Function for reading the time source, the 32-bit counter is copied atomically
+ */
+uint32_t hal_millis(void) {
+    uint32_t now;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        now = millis;
+    }
+    return now;
+}
+
+#else // host build
+
+#include <stdio.h>
+#include <time.h>
+
+volatile uint8_t PINB, DDRB, PORTB;
+volatile uint8_t PINC, DDRC, PORTC;
+volatile uint8_t PIND, DDRD, PORTD;
+volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t TWBR, TWSR, TWAR, TWDR, TWCR;
+volatile uint8_t SPCR, SPSR, SPDR;
+volatile uint8_t GPIOR0, GPIOR1, GPIOR2;
+volatile uint8_t SREG;              // interrupts are disabled after reset, like on the chip
+
+uint8_t hal_verbose;
+
+// interrupts raised while the global flag was clear
+#define HAL_PENDING 8
+static void (*pending[HAL_PENDING])(void);
+static uint8_t pending_count;
+
+static uint64_t now_ns;             // virtual clock
+static void (*time_hook)(uint64_t now_us);
+static uint8_t in_hook;             // the hook itself may advance the clock
+
+static void run_pending(void);
+
+// vectors without an ISR() in the program, like __bad_interrupt on AVR
+static void bad_interrupt(void) {}
+void PCINT0_vect(void) __attribute__((weak, alias("bad_interrupt")));
+void PCINT1_vect(void) __attribute__((weak, alias("bad_interrupt")));
+void PCINT2_vect(void) __attribute__((weak, alias("bad_interrupt")));
+void TIMER0_OVF_vect(void) __attribute__((weak, alias("bad_interrupt")));
+void TIMER1_OVF_vect(void) __attribute__((weak, alias("bad_interrupt")));
+void TWI_vect(void) __attribute__((weak, alias("bad_interrupt")));
+
+/*
+ * Function for running one interrupt routine the way the CPU does,
+ * with the global flag cleared and restored by RETI
+ */
+static void run_isr(void (*vector)(void)) {
+    SREG &= (uint8_t)~(1 << SREG_I);
+    vector();
+    SREG |= (1 << SREG_I);
+    run_pending();
+}
+
+/*
+ * Function for running the latched interrupts once the global flag is set again
+ */
+static void run_pending(void) {
+    while (pending_count && (SREG & (1 << SREG_I))) {
+        void (*vector)(void) = pending[0];
+        pending_count--;
+        for (uint8_t i = 0; i < pending_count; i++) pending[i] = pending[i + 1];
+        run_isr(vector);
+    }
+}
+
+void hal_irq(void (*vector)(void)) {
+    if (SREG & (1 << SREG_I)) {
+        run_isr(vector);
+        return;
+    }
+    // one flag per vector, like the interrupt flag registers
+    for (uint8_t i = 0; i < pending_count; i++) {
+        if (pending[i] == vector) return;
+    }
+    if (pending_count < HAL_PENDING) pending[pending_count++] = vector;
+}
+
+void hal_set_pin(volatile uint8_t *pinreg, uint8_t bit, uint8_t level) {
+    uint8_t old = *pinreg;
+
+    if (level) *pinreg |= (1 << bit);
+    else *pinreg &= (uint8_t)~(1 << bit);
+    if (old == *pinreg) return;
+
+    if (pinreg == &PINB && (PCICR & (1 << PCIE0)) && (PCMSK0 & (1 << bit))) hal_irq(PCINT0_vect);
+    if (pinreg == &PINC && (PCICR & (1 << PCIE1)) && (PCMSK1 & (1 << bit))) hal_irq(PCINT1_vect);
+    if (pinreg == &PIND && (PCICR & (1 << PCIE2)) && (PCMSK2 & (1 << bit))) hal_irq(PCINT2_vect);
+}
+
+void hal_sei(void) {
+    SREG |= (1 << SREG_I);
+    run_pending();
+}
+
+uint8_t hal_irq_save(void) {
+    uint8_t sreg = SREG;
+    cli();
+    return sreg;
+}
+
+void hal_irq_restore(uint8_t *sreg) {
+    SREG = *sreg;
+    run_pending();
+}
+
+void hal_advance_ns(uint32_t ns) {
+    now_ns += ns;
+    if (time_hook && !in_hook) {
+        in_hook = 1;
+        time_hook(now_ns / 1000);
+        in_hook = 0;
+    }
+}
+
+void hal_delay_us(uint32_t us) {
+    // step in 100 us slices so device models see the time pass
+    while (us > 100) {
+        hal_advance_ns(100000UL);
+        us -= 100;
+    }
+    hal_advance_ns(us * 1000UL);
+}
+
+uint64_t hal_micros(void) {
+    return now_ns / 1000;
+}
+
+uint32_t hal_millis(void) {
+    return (uint32_t)(now_ns / 1000000UL);
+}
+
+uint64_t hal_host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void hal_set_time_hook(void (*hook)(uint64_t now_us)) {
+    time_hook = hook;
+}
+
+void uart_puts(const char *s) {
+    if (hal_verbose) fputs(s, stderr);
+}
+
+#endif // __AVR__
@@ -0,0 +1,205 @@
+ /**
+  * @file hal.h
+  * @defgroup hal Hardware Abstraction Layer <hal.h>
+  * @code #include <hal.h> @endcode
+  *
+  * @brief Thin hardware abstraction for building the libraries on AVR and on a host PC
+  *
+  * On AVR (__AVR__ defined) the header only pulls in the avr-libc headers
+  * the libraries use, so the firmware is compiled exactly as before.
+  *
+  * On a host (x86 Linux, PlatformIO `native` environment or CMake) it
+  * provides the same names backed by plain C:
+  *  - I/O registers are ordinary variables (register file in hal.c),
+  *  - ISR() defines a normal function which hal_irq() calls with the
+  *    global interrupt flag in SREG honoured, cli()/sei() and
+  *    ATOMIC_BLOCK() work on that flag,
+  *  - PROGMEM data lives in normal memory,
+  *  - _delay_ms()/_delay_us() advance a virtual clock instead of spinning,
+  *    so timeouts of the drivers cost no wall-clock time.
+  *
+  * The time source hal_millis() is available on both targets. On AVR it
+  * counts the milliseconds passed to hal_tick() by a timer interrupt.
+  * @{
+  */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#if defined(__AVR__)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+
+/**
+ * @brief Advance the millisecond time source, call it from a periodic timer interrupt
+ * @param ms milliseconds since the previous call
+ */
+void hal_tick(uint8_t ms);
+
+#else // host build
+
+// -- I/O registers of the ATmega328P used by the libraries ----------------
+extern volatile uint8_t PINB, DDRB, PORTB;
+extern volatile uint8_t PINC, DDRC, PORTC;
+extern volatile uint8_t PIND, DDRD, PORTD;
+extern volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+extern volatile uint8_t TWBR, TWSR, TWAR, TWDR, TWCR;
+extern volatile uint8_t SPCR, SPSR, SPDR;
+extern volatile uint8_t GPIOR0, GPIOR1, GPIOR2;
+extern volatile uint8_t SREG;
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+
+#define TWIE  0
+#define TWEN  2
+#define TWWC  3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA  6
+#define TWINT 7
+#define TWPS0 0
+#define TWPS1 1
+
+#define SPR0 0
+#define MSTR 4
+#define SPE  6
+#define SPIF 7
+
+#define SREG_I 7
+
+// -- Interrupts -----------------------------------------------------------
+#define ISR(vector) void vector(void)
+
+void PCINT0_vect(void);
+void PCINT1_vect(void);
+void PCINT2_vect(void);
+void TIMER0_OVF_vect(void);
+void TIMER1_OVF_vect(void);
+void TWI_vect(void);
+
+#define cli() (SREG &= (uint8_t)~(1 << SREG_I))
+#define sei() hal_sei()
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON      1
+// restores SREG on every way out of the block, like the avr-libc version
+#define ATOMIC_BLOCK(type) \
+    for (uint8_t hal_sreg __attribute__((cleanup(hal_irq_restore))) = hal_irq_save(), \
+         hal_once = 1; hal_once; hal_once = 0)
+
+/**
+ * @brief Set the global interrupt flag and run the interrupts latched while it was clear
+ */
+void hal_sei(void);
+
+/**
+ * @brief Raise an interrupt
+ * @param vector interrupt routine, eg. PCINT0_vect
+ * @note With the global flag set the routine runs right away and the flag
+ * is cleared while it runs. Otherwise it is latched until sei() or the end
+ * of an ATOMIC_BLOCK, like a pending interrupt flag.
+ */
+void hal_irq(void (*vector)(void));
+
+uint8_t hal_irq_save(void);
+void hal_irq_restore(uint8_t *sreg);
+
+/**
+ * @brief Drive an input pin from a device model
+ * @param pinreg input register, eg. &PINB
+ * @param bit    pin number
+ * @param level  0 or 1
+ * @note A change of the level raises the pin change interrupt of the pin
+ * when it is enabled in PCICR and PCMSKn.
+ */
+void hal_set_pin(volatile uint8_t *pinreg, uint8_t bit, uint8_t level);
+
+// -- Program memory -------------------------------------------------------
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+// -- Delays and time ------------------------------------------------------
+#define _delay_ms(ms) hal_delay_us((uint32_t)((ms) * 1000UL))
+#define _delay_us(us) hal_delay_us((uint32_t)(us))
+
+/**
+ * @brief Busy-wait replacement, advances the virtual clock by us microseconds
+ */
+void hal_delay_us(uint32_t us);
+
+/**
+ * @brief Advance the virtual clock, used by bus and device models for transfer times
+ */
+void hal_advance_ns(uint32_t ns);
+
+/**
+ * @brief Virtual time in microseconds since start
+ */
+uint64_t hal_micros(void);
+
+/**
+ * @brief Monotonic wall-clock time of the host in nanoseconds, for benchmarks
+ */
+uint64_t hal_host_ns(void);
+
+/**
+ * @brief Register a function called whenever the virtual clock advances
+ * @param hook function receiving the new virtual time in microseconds, NULL to remove
+ * @note Device models use it to raise interrupts while the driver waits in a delay.
+ */
+void hal_set_time_hook(void (*hook)(uint64_t now_us));
+
+/**
+ * @brief Debug output of the drivers, printed to stderr when hal_verbose is set
+ */
+void uart_puts(const char *s);
+extern uint8_t hal_verbose;
+
+#endif // __AVR__
+
+/**
+ * @brief Milliseconds since start
+ */
+uint32_t hal_millis(void);
+
+/** @} */
+
+#endif
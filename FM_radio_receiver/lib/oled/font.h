@@ -7,7 +7,7 @@
  */
 #ifndef _font_h_
 # define _font_h_
-# include <avr/pgmspace.h>
+# include <hal.h>
 
 // extern const char ssd1306oled_font[][6] PROGMEM;
 // extern const char special_char[][2] PROGMEM;
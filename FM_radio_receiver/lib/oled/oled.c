@@ -58,9 +58,109 @@ static struct {
 } cursorPosition;
 
 static uint8_t charMode = NORMALSIZE;
+// DOUBLESIZE bit doubling of a nibble: bit n of the index sets bits 2n and 2n+1
+static const uint8_t doubleNibble[16] PROGMEM = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF
+};
 #if defined GRAPHICMODE
 # include <stdlib.h>
 static uint8_t displayBuffer[DISPLAY_HEIGHT/8][DISPLAY_WIDTH];
+// changed column range of every page since the last flush, clean if dirtyMin > dirtyMax
+static uint8_t dirtyMin[DISPLAY_HEIGHT/8];
+static uint8_t dirtyMax[DISPLAY_HEIGHT/8];
+
+static void oled_mark_clean(void) {
+    memset(dirtyMin, 0xff, sizeof(dirtyMin));
+    memset(dirtyMax, 0x00, sizeof(dirtyMax));
+}
+#if OLED_SHADOW && defined I2C
+// pages written while an asynchronous flush was on the bus, the panel may
+// show their old or their new bytes whatever the signatures say
+static uint8_t shadowStale;
+static volatile uint8_t asyncBusy;
+#endif
+// write one byte to the buffer and widen the dirty range of its page if it changes
+static void oled_write_buffer(uint8_t page, uint8_t x, uint8_t data) {
+    if (displayBuffer[page][x] == data) return;
+    displayBuffer[page][x] = data;
+    if (x < dirtyMin[page]) dirtyMin[page] = x;
+    if (x > dirtyMax[page]) dirtyMax[page] = x;
+#if OLED_SHADOW && defined I2C
+    if (asyncBusy) shadowStale |= 1 << page;
+#endif
+}
+// bytes a window costs besides its data: addressing command and two I2C headers
+#if defined (SSD1306) || defined (SSD1309)
+# define WINDOW_COST (6+2+2)
+#elif defined SH1106
+# define WINDOW_COST (5+2+2)
+#endif
+// send columns of a display line from the buffer
+static void oled_send_block(uint8_t x, uint8_t line, uint8_t width) {
+    oled_display_window(x, line, width, 1);
+}
+#if OLED_SHADOW
+# define SHADOW_RUNS (DISPLAY_WIDTH/OLED_SHADOW_RUN)
+// signature of every run of OLED_SHADOW_RUN columns as last sent to the panel,
+// valid once a whole frame was sent
+static uint16_t shadow[DISPLAY_HEIGHT/8][SHADOW_RUNS];
+static uint8_t shadowValid;
+
+// Fletcher-like signature, the second sum makes it depend on the order of the bytes
+static uint16_t oled_signature(const uint8_t *data) {
+    uint8_t a = 0, b = 0;
+    for (uint8_t i = 0; i < OLED_SHADOW_RUN; i++) {
+        a += data[i];
+        b += a;
+    }
+    return ((uint16_t)b << 8) | a;
+}
+// the panel shows the whole buffer, take the signatures of all runs
+static void oled_shadow_sync(void) {
+    for (uint8_t i = 0; i < DISPLAY_HEIGHT/8; i++){
+        for (uint8_t r = 0; r < SHADOW_RUNS; r++){
+            shadow[i][r] = oled_signature(&displayBuffer[i][r*OLED_SHADOW_RUN]);
+        }
+    }
+    shadowValid = 1;
+#if defined I2C
+    shadowStale = 0;
+#endif
+}
+// send the runs of columns from..to of a line whose signature changed, the
+// columns outside from..to must equal the panel. Two changed runs closer than
+// WINDOW_COST go out as one transfer with the clean bytes between them.
+static void oled_shadow_flush(uint8_t line, uint8_t from, uint8_t to) {
+    uint8_t start = 0, end = 0, pending = 0;
+#if defined I2C
+    uint8_t stale = shadowStale & (1 << line);
+    shadowStale &= ~(1 << line);
+#else
+    uint8_t stale = 0;
+#endif
+    for (uint8_t r = from/OLED_SHADOW_RUN; r <= to/OLED_SHADOW_RUN; r++){
+        uint16_t signature = oled_signature(&displayBuffer[line][r*OLED_SHADOW_RUN]);
+        if (signature == shadow[line][r] && !stale) continue;
+        shadow[line][r] = signature;
+
+        uint8_t x1 = r*OLED_SHADOW_RUN;
+        uint8_t x2 = x1 + OLED_SHADOW_RUN - 1;
+        if (x1 < from) x1 = from;
+        if (x2 > to) x2 = to;
+        if (pending && x1 - end - 1 > WINDOW_COST) {
+            oled_send_block(start, line, end - start + 1);
+            pending = 0;
+        }
+        if (!pending) {
+            start = x1;
+            pending = 1;
+        }
+        end = x2;
+    }
+    if (pending) oled_send_block(start, line, end - start + 1);
+}
+#endif
 #elif defined TEXTMODE
 #else
 # error "No valid displaymode! Refer oled.h"
@@ -100,16 +200,13 @@ const uint8_t init_sequence [] PROGMEM = {    // Initialization Sequence
 // #pragma mark LCD COMMUNICATION
 void oled_command(uint8_t cmd[], uint8_t size) {
 #if defined I2C
-    twi_start();
-    twi_write((OLED_I2C_ADR<<1) | TWI_WRITE);
-    // i2c_start((OLED_I2C_ADR << 1) | 0);
-    twi_write(0x00);
-    // i2c_byte(0x00);    // 0x00 for command, 0x40 for data
-    for (uint8_t i=0; i<size; i++) {
-        twi_write(cmd[i]);
-        // i2c_byte(cmd[i]);
-    }
-    twi_stop();
+    static const uint8_t control = 0x00;    // 0x00 for command, 0x40 for data
+    twi_xfer_t xfer = {
+        .addr = OLED_I2C_ADR,
+        .hdr = &control, .hlen = 1,
+        .wbuf = cmd, .wlen = size,
+    };
+    twi_transfer(&xfer);
 #elif defined SPI
 	OLED_PORT &= ~(1 << CS_PIN);
 	OLED_PORT &= ~(1 << DC_PIN);
@@ -122,17 +219,13 @@ void oled_command(uint8_t cmd[], uint8_t size) {
 }
 void oled_data(uint8_t data[], uint16_t size) {
 #if defined I2C
-    twi_start();
-    twi_write((OLED_I2C_ADR<<1) | TWI_WRITE);
-    // i2c_start((OLED_I2C_ADR << 1) | 0);
-    twi_write(0x40);
-    // i2c_byte(0x40);    // 0x00 for command, 0x40 for data
-    for (uint16_t i = 0; i<size; i++) {
-        twi_write(data[i]);
-        // i2c_byte(data[i]);
-    }
-    twi_stop();
-    // i2c_stop();
+    static const uint8_t control = 0x40;    // 0x00 for command, 0x40 for data
+    twi_xfer_t xfer = {
+        .addr = OLED_I2C_ADR,
+        .hdr = &control, .hlen = 1,
+        .wbuf = data, .wlen = size,
+    };
+    twi_transfer(&xfer);
 #elif defined SPI
 	OLED_PORT &= ~(1 << CS_PIN);
 	OLED_PORT |= (1 << DC_PIN);
@@ -149,6 +242,7 @@ void oled_init(uint8_t dispAttr){
 #if defined I2C
     // i2c_init();
     twi_init();
+    twi_set_device_clock(OLED_I2C_ADR, F_SCL_FAST);
 #elif defined SPI
 	DDRB |= (1 << PB2)|(1 << PB3)|(1 << PB5);
     SPCR = (1 << SPE)|(1<<MSTR)|(1<<SPR0);
@@ -171,10 +265,9 @@ void oled_gotoxy(uint8_t x, uint8_t y){
     x = x * sizeof(FONT[0]);
     oled_goto_xpix_y(x,y);
 }
-void oled_goto_xpix_y(uint8_t x, uint8_t y){
-    if( x > (DISPLAY_WIDTH) || y > (DISPLAY_HEIGHT/8-1)) return;// out of display
-    cursorPosition.x=x;
-    cursorPosition.y=y;
+#if defined TEXTMODE || defined SH1106
+// point the display RAM address to pixel column x of line y
+static void oled_address(uint8_t x, uint8_t y){
 #if defined (SSD1306) || defined (SSD1309)
     uint8_t commandSequence[] = {0xb0+y, 0x21, x, 0x7f};
 #elif defined SH1106
@@ -182,13 +275,20 @@ void oled_goto_xpix_y(uint8_t x, uint8_t y){
 #endif
     oled_command(commandSequence, sizeof(commandSequence));
 }
+#endif
+void oled_goto_xpix_y(uint8_t x, uint8_t y){
+    if( x > (DISPLAY_WIDTH) || y > (DISPLAY_HEIGHT/8-1)) return;// out of display
+    cursorPosition.x=x;
+    cursorPosition.y=y;
+#if defined TEXTMODE
+    // GRAPHICMODE writes the buffer, its flushes address the display themselves
+    oled_address(x, y);
+#endif
+}
 void oled_clrscr(void){
 #ifdef GRAPHICMODE
-    for (uint8_t i = 0; i < DISPLAY_HEIGHT/8; i++){
-        memset(displayBuffer[i], 0x00, sizeof(displayBuffer[i]));
-        oled_gotoxy(0,i);
-        oled_data(displayBuffer[i], sizeof(displayBuffer[i]));
-    }
+    memset(displayBuffer, 0x00, sizeof(displayBuffer));
+    oled_display();
 #elif defined TEXTMODE
     uint8_t displayBuffer[DISPLAY_WIDTH];
     memset(displayBuffer, 0x00, sizeof(displayBuffer));
@@ -269,27 +369,19 @@ void oled_putc(char c){
             // print char at display
 #ifdef GRAPHICMODE
             if (charMode == DOUBLESIZE) {
-                uint16_t doubleChar[sizeof(FONT[0])];
-                uint8_t dChar;
+                uint8_t dChar, upper, lower;
                 if ((cursorPosition.x+2*sizeof(FONT[0]))>DISPLAY_WIDTH) break;
                 
-                for (uint8_t i=0; i < sizeof(FONT[0]); i++) {
-                    doubleChar[i] = 0;
-                    dChar = pgm_read_byte(&(FONT[(uint8_t)c][i]));
-                    for (uint8_t j=0; j<8; j++) {
-                        if ((dChar & (1 << j))) {
-                            doubleChar[i] |= (1 << (j*2));
-                            doubleChar[i] |= (1 << ((j*2)+1));
-                        }
-                    }
-                }
                 for (uint8_t i = 0; i < sizeof(FONT[0]); i++)
                 {
-                    // load bit-pattern from flash
-                    displayBuffer[cursorPosition.y+1][cursorPosition.x+(2*i)] = doubleChar[i] >> 8;
-                    displayBuffer[cursorPosition.y+1][cursorPosition.x+(2*i)+1] = doubleChar[i] >> 8;
-                    displayBuffer[cursorPosition.y][cursorPosition.x+(2*i)] = doubleChar[i] & 0xff;
-                    displayBuffer[cursorPosition.y][cursorPosition.x+(2*i)+1] = doubleChar[i] & 0xff;
+                    // load bit-pattern from flash, each nibble doubled by the table
+                    dChar = pgm_read_byte(&(FONT[(uint8_t)c][i]));
+                    lower = pgm_read_byte(&doubleNibble[dChar & 0x0f]);
+                    upper = pgm_read_byte(&doubleNibble[dChar >> 4]);
+                    oled_write_buffer(cursorPosition.y+1, cursorPosition.x+(2*i), upper);
+                    oled_write_buffer(cursorPosition.y+1, cursorPosition.x+(2*i)+1, upper);
+                    oled_write_buffer(cursorPosition.y, cursorPosition.x+(2*i), lower);
+                    oled_write_buffer(cursorPosition.y, cursorPosition.x+(2*i)+1, lower);
                 }
                 cursorPosition.x += sizeof(FONT[0])*2;
             } else {
@@ -298,65 +390,27 @@ void oled_putc(char c){
                 for (uint8_t i = 0; i < sizeof(FONT[0]); i++)
                 {
                     // load bit-pattern from flash
-                    displayBuffer[cursorPosition.y][cursorPosition.x+i] =pgm_read_byte(&(FONT[(uint8_t)c][i]));
+                    oled_write_buffer(cursorPosition.y, cursorPosition.x+i, pgm_read_byte(&(FONT[(uint8_t)c][i])));
                 }
                 cursorPosition.x += sizeof(FONT[0]);
             }
 #elif defined TEXTMODE
             if (charMode == DOUBLESIZE) {
-                uint16_t doubleChar[sizeof(FONT[0])];
+                uint8_t upper[sizeof(FONT[0])*2], lower[sizeof(FONT[0])*2];
                 uint8_t dChar;
                 if ((cursorPosition.x+2*sizeof(FONT[0]))>DISPLAY_WIDTH) break;
                 
-                for (uint8_t i=0; i < sizeof(FONT[0]); i++) {
-                    doubleChar[i] = 0;
-                    dChar = pgm_read_byte(&(FONT[(uint8_t)c][i]));
-                    for (uint8_t j=0; j<8; j++) {
-                        if ((dChar & (1 << j))) {
-                            doubleChar[i] |= (1 << (j*2));
-                            doubleChar[i] |= (1 << ((j*2)+1));
-                        }
-                    }
-                }
-                uint8_t data[sizeof(FONT[0])*2];
                 for (uint8_t i = 0; i < sizeof(FONT[0]); i++)
                 {
-                    // print font to ram, print 6 columns
-                    data[i<<1]=(doubleChar[i] & 0xff);
-                    data[(i<<1)+1]=(doubleChar[i] & 0xff);
-                }
-                oled_data(data, sizeof(FONT[0])*2);
-                
-#if defined (SSD1306) || defined (SSD1309)
-                uint8_t commandSequence[] = {0xb0+cursorPosition.y+1,
-                    0x21,
-                    cursorPosition.x,
-                    0x7f};
-#elif defined SH1106
-                uint8_t commandSequence[] = {0xb0+cursorPosition.y+1,
-                    0x21,
-                    0x00+((2+cursorPosition.x) & (0x0f)),
-                    0x10+( ((2+cursorPosition.x) & (0xf0)) >> 4 ),
-                    0x7f};
-#endif
-                oled_command(commandSequence, sizeof(commandSequence));
-                
-                for (uint8_t i = 0; i < sizeof(FONT[0]); i++)
-                {
-                    // print font to ram, print 6 columns
-                    data[i<<1]=(doubleChar[i] >> 8);
-                    data[(i<<1)+1]=(doubleChar[i] >> 8);
+                    // load bit-pattern from flash, each nibble doubled by the table
+                    dChar = pgm_read_byte(&(FONT[(uint8_t)c][i]));
+                    lower[2*i] = lower[2*i+1] = pgm_read_byte(&doubleNibble[dChar & 0x0f]);
+                    upper[2*i] = upper[2*i+1] = pgm_read_byte(&doubleNibble[dChar >> 4]);
                 }
-                oled_data(data, sizeof(FONT[0])*2);
-                
-                commandSequence[0] = 0xb0+cursorPosition.y;
-#if defined (SSD1306) || defined (SSD1309)
-                commandSequence[2] = cursorPosition.x+(2*sizeof(FONT[0]));
-#elif defined SH1106
-                commandSequence[2] = 0x00+((2+cursorPosition.x+(2*sizeof(FONT[0]))) & (0x0f));
-                commandSequence[3] = 0x10+( ((2+cursorPosition.x+(2*sizeof(FONT[0]))) & (0xf0)) >> 4 );
-#endif
-                oled_command(commandSequence, sizeof(commandSequence));
+                oled_data(lower, sizeof(lower));
+                oled_address(cursorPosition.x, cursorPosition.y+1);
+                oled_data(upper, sizeof(upper));
+                oled_address(cursorPosition.x+(2*sizeof(FONT[0])), cursorPosition.y);
                 cursorPosition.x += sizeof(FONT[0])*2;
             } else {
                 uint8_t data[sizeof(FONT[0])];
@@ -425,9 +479,9 @@ uint8_t oled_drawPixel(uint8_t x, uint8_t y, uint8_t color){
     if( x > DISPLAY_WIDTH-1 || y > (DISPLAY_HEIGHT-1)) return 1; // out of Display
     
     if( color == WHITE){
-        displayBuffer[(y / 8)][x] |= (1 << (y % 8));
+        oled_write_buffer(y / 8, x, displayBuffer[(y / 8)][x] | (1 << (y % 8)));
     } else {
-        displayBuffer[(y / 8)][x] &= ~(1 << (y % 8));
+        oled_write_buffer(y / 8, x, displayBuffer[(y / 8)][x] & ~(1 << (y % 8)));
     }
     
     return 0;
@@ -531,20 +585,78 @@ uint8_t oled_drawBitmap(uint8_t x, uint8_t y, const uint8_t *picture, uint8_t wi
     }
     return result;
 }
+uint8_t oled_drawColumns(uint8_t x, uint8_t line, const uint8_t *columns, uint8_t width){
+    if( line > (DISPLAY_HEIGHT/8-1) || x + width > DISPLAY_WIDTH) return 1; // out of Display
+    for (uint8_t i = 0; i < width; i++) {
+        oled_write_buffer(line, x + i, pgm_read_byte(&columns[i]));
+    }
+    return 0;
+}
 void oled_display() {
+    while (oled_flush_busy());
+#if OLED_SHADOW
+    if (shadowValid) {
+        for (uint8_t i = 0; i < DISPLAY_HEIGHT/8; i++){
+            oled_shadow_flush(i, 0, DISPLAY_WIDTH-1);
+        }
+        oled_mark_clean();
+        return;
+    }
+#endif
+    oled_display_window(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT/8);
+#if OLED_SHADOW
+    oled_shadow_sync();
+#endif
+    oled_mark_clean();
+}
+// take the dirty range of line first as a window and mark it clean, on the
+// SSD1306 the next dirty lines join the window while the clean bytes that
+// widen it cost less than an addressing header of their own. Returns the
+// last line of the window.
+static uint8_t oled_take_window(uint8_t first, uint8_t *x1, uint8_t *x2) {
+    uint8_t i = first;
+    *x1 = dirtyMin[i];
+    *x2 = dirtyMax[i];
 #if defined (SSD1306) || defined (SSD1309)
-    oled_gotoxy(0,0);
-    oled_data(&displayBuffer[0][0], DISPLAY_WIDTH*DISPLAY_HEIGHT/8);
-#elif defined SH1106
-    for (uint8_t i = 0; i < DISPLAY_HEIGHT/8; i++){
-        oled_gotoxy(0,i);
-        oled_data(displayBuffer[i], sizeof(displayBuffer[i]));
+    while (i < DISPLAY_HEIGHT/8-1 && dirtyMin[i+1] <= dirtyMax[i+1]) {
+        uint8_t n1 = (dirtyMin[i+1] < *x1) ? dirtyMin[i+1] : *x1;
+        uint8_t n2 = (dirtyMax[i+1] > *x2) ? dirtyMax[i+1] : *x2;
+        uint16_t merged = (uint16_t)(n2 - n1 + 1) * (i - first + 2);
+        uint16_t apart = (uint16_t)(*x2 - *x1 + 1) * (i - first + 1) + dirtyMax[i+1] - dirtyMin[i+1] + 1 + WINDOW_COST;
+        if (merged > apart) break;
+        dirtyMin[i] = 0xff;
+        dirtyMax[i] = 0x00;
+        i++;
+        *x1 = n1;
+        *x2 = n2;
     }
 #endif
+    dirtyMin[i] = 0xff;
+    dirtyMax[i] = 0x00;
+    return i;
+}
+void oled_flush_dirty(void) {
+    for (uint8_t i = 0; i < DISPLAY_HEIGHT/8; i++){
+        if (dirtyMin[i] > dirtyMax[i]) continue;
+#if OLED_SHADOW
+        if (shadowValid) {
+            oled_shadow_flush(i, dirtyMin[i], dirtyMax[i]);
+            dirtyMin[i] = 0xff;
+            dirtyMax[i] = 0x00;
+            continue;
+        }
+#endif
+        uint8_t first = i;
+        uint8_t x1, x2;
+        i = oled_take_window(first, &x1, &x2);
+        oled_display_window(x1, first, x2 - x1 + 1, i - first + 1);
+    }
 }
 void oled_clear_buffer() {
     for (uint8_t i = 0; i < DISPLAY_HEIGHT/8; i++){
-        memset(displayBuffer[i], 0x00, sizeof(displayBuffer[i]));
+        for (uint8_t x = 0; x < DISPLAY_WIDTH; x++){
+            oled_write_buffer(i, x, 0x00);
+        }
     }
 }
 uint8_t oled_check_buffer(uint8_t x, uint8_t y) {
@@ -556,7 +668,174 @@ void oled_display_block(uint8_t x, uint8_t line, uint8_t width) {
     if (x + width > DISPLAY_WIDTH) { // no -1 here, x alone is width 1
         width = DISPLAY_WIDTH - x;
     }
-    oled_goto_xpix_y(x,line);
-    oled_data(&displayBuffer[line][x], width);
+#if OLED_SHADOW
+    // the signatures do not know this block, the next oled_display() sends all
+    shadowValid = 0;
+#endif
+    oled_send_block(x, line, width);
 }
+void oled_display_window(uint8_t x, uint8_t line, uint8_t width, uint8_t lines) {
+    if (line > (DISPLAY_HEIGHT/8-1) || x > DISPLAY_WIDTH - 1){return;}
+    if (x + width > DISPLAY_WIDTH) width = DISPLAY_WIDTH - x;
+    if (line + lines > DISPLAY_HEIGHT/8) lines = DISPLAY_HEIGHT/8 - line;
+    if (width == 0 || lines == 0) return;
+
+    // a page of an asynchronous flush could land between addressing and data
+    while (oled_flush_busy());
+#if defined (SSD1306) || defined (SSD1309)
+    // horizontal addressing wraps the data to the next line inside the window
+    uint8_t commandSequence[] = {0x21, x, x+width-1, 0x22, line, line+lines-1};
+    oled_command(commandSequence, sizeof(commandSequence));
+    if (width == DISPLAY_WIDTH) {
+        // whole lines follow each other in the buffer, one data transfer
+        oled_data(displayBuffer[line], (uint16_t)DISPLAY_WIDTH * lines);
+    } else {
+        for (uint8_t i = 0; i < lines; i++){
+            oled_data(&displayBuffer[line+i][x], width);
+        }
+    }
+#elif defined SH1106
+    // no column or page window on the SH1106, every line gets its own address
+    for (uint8_t i = 0; i < lines; i++){
+        oled_address(x, line+i);
+        oled_data(&displayBuffer[line+i][x], width);
+    }
+#endif
+}
+#if defined I2C
+/*
+ * Asynchronous flush: the dirty ranges are taken as windows like
+ * oled_flush_dirty() does and sent with the data straight from the buffer.
+ * The completion callback submits the next transaction, so only one
+ * transaction of the flush waits in the queue. An SSD1306 window is an
+ * addressing command followed by the data of its lines, which nothing can
+ * get between since GRAPHICMODE sends addressing commands only in flushes.
+ * A SH1106 line is one transaction with its address in the header (Co bit
+ * set). The ranges are marked clean when the flush starts: a byte written
+ * while it is on the bus makes its page dirty again and goes out with the
+ * next flush, so the panel may show a mix of two frames for one flush
+ * period but never keeps it.
+ */
+static struct {
+    uint8_t line;
+    uint8_t x;
+    uint8_t width;
+    uint8_t lines;
+} asyncWindows[DISPLAY_HEIGHT/8];
+static uint8_t asyncCount;
+static volatile uint8_t asyncNext;      // window on the bus
+static volatile uint8_t asyncLine;      // line of the window on the bus, 0xff = its addressing
+#if !OLED_SHADOW
+static volatile uint8_t asyncBusy;
+#endif
+static volatile uint8_t asyncStalled;   // the queue was full when the callback submitted
+static uint8_t asyncHeader[7];
+static void oled_async_done(twi_xfer_t *xfer);
+static twi_xfer_t asyncXfer = {
+    .addr = OLED_I2C_ADR,
+    .hdr = asyncHeader,
+    .callback = oled_async_done,
+};
+
+// submit the transaction of asyncNext and asyncLine, from the main loop or from TWI_vect
+static void oled_async_submit(void) {
+    uint8_t line = asyncWindows[asyncNext].line;
+    uint8_t x = asyncWindows[asyncNext].x;
+    uint8_t width = asyncWindows[asyncNext].width;
+#if defined (SSD1306) || defined (SSD1309)
+    if (asyncLine == 0xff) {
+        uint8_t header[] = {0x00, 0x21, x, x+width-1, 0x22, line, line+asyncWindows[asyncNext].lines-1};
+        memcpy(asyncHeader, header, sizeof(header));
+        asyncXfer.hlen = sizeof(header);
+        asyncXfer.wlen = 0;
+    } else {
+        asyncHeader[0] = 0x40;
+        asyncXfer.hlen = 1;
+        asyncXfer.wbuf = &displayBuffer[line+asyncLine][x];
+        asyncXfer.wlen = width;
+        if (width == DISPLAY_WIDTH) {
+            // whole lines follow each other in the buffer, one transaction
+            asyncXfer.wlen = (uint16_t)DISPLAY_WIDTH * asyncWindows[asyncNext].lines;
+            asyncLine = asyncWindows[asyncNext].lines - 1;
+        }
+    }
+#elif defined SH1106
+    line += asyncLine;
+    uint8_t header[] = {0x80, 0xb0+line, 0x80, 0x00+((2+x) & (0x0f)), 0x80, 0x10+( ((2+x) & (0xf0)) >> 4 ), 0x40};
+    memcpy(asyncHeader, header, sizeof(header));
+    asyncXfer.hlen = sizeof(header);
+    asyncXfer.wbuf = &displayBuffer[line][x];
+    asyncXfer.wlen = width;
+#endif
+    if (twi_submit(&asyncXfer) != 0) asyncStalled = 1;
+}
+// completion callback, runs in TWI_vect
+static void oled_async_done(twi_xfer_t *xfer) {
+    (void)xfer;
+    if (++asyncLine >= asyncWindows[asyncNext].lines) {
+        if (++asyncNext >= asyncCount) {
+            asyncBusy = 0;
+            return;
+        }
+#if defined (SSD1306) || defined (SSD1309)
+        asyncLine = 0xff;
+#else
+        asyncLine = 0;
+#endif
+    }
+    oled_async_submit();
+}
+uint8_t oled_flush_async(void) {
+    if (oled_flush_busy()) return 1;
+
+    asyncCount = 0;
+    for (uint8_t i = 0; i < DISPLAY_HEIGHT/8; i++){
+        if (dirtyMin[i] > dirtyMax[i]) continue;
+        uint8_t first = i;
+        uint8_t x1, x2;
+        i = oled_take_window(first, &x1, &x2);
+#if OLED_SHADOW
+        // the panel gets the bytes of now in every line of the window,
+        // later writes mark the page stale
+        for (uint8_t line = first; line <= i; line++){
+            for (uint8_t r = x1/OLED_SHADOW_RUN; r <= x2/OLED_SHADOW_RUN; r++){
+                shadow[line][r] = oled_signature(&displayBuffer[line][r*OLED_SHADOW_RUN]);
+            }
+        }
+#endif
+        asyncWindows[asyncCount].line = first;
+        asyncWindows[asyncCount].x = x1;
+        asyncWindows[asyncCount].width = x2 - x1 + 1;
+        asyncWindows[asyncCount].lines = i - first + 1;
+        asyncCount++;
+    }
+    if (asyncCount == 0) return 0;
+
+    asyncNext = 0;
+#if defined (SSD1306) || defined (SSD1309)
+    asyncLine = 0xff;
+#else
+    asyncLine = 0;
+#endif
+    asyncBusy = 1;
+    oled_async_submit();
+    return 0;
+}
+uint8_t oled_flush_busy(void) {
+    if (asyncStalled) {
+        // nothing of the flush is queued, the callback cannot run meanwhile
+        asyncStalled = 0;
+        oled_async_submit();
+    }
+    return asyncBusy;
+}
+#elif defined SPI
+uint8_t oled_flush_async(void) {
+    oled_flush_dirty();
+    return 0;
+}
+uint8_t oled_flush_busy(void) {
+    return 0;
+}
+#endif
 #endif
@@ -53,15 +53,22 @@ extern "C" {
 #endif
 
 #include <inttypes.h>
-#include <avr/pgmspace.h>
+#include <hal.h>
 
 	/* TODO: define bus */
 #define I2C  // I2C or SPI	
     /* TODO: define displaycontroller */
+#if !defined (SSD1306) && !defined (SSD1309)
 #define SH1106  // or SSD1306, check datasheet of your display
+#endif
     /* TODO: define displaymode */
 #define GRAPHICMODE  // for text and graphic
     // TEXTMODE // for only text to display,
+    /* optional: flushes of GRAPHICMODE send only what differs from the panel */
+#ifndef OLED_SHADOW
+#define OLED_SHADOW 0  // 1: keep a signature of every OLED_SHADOW_RUN columns sent, 2 bytes RAM each
+#endif
+#define OLED_SHADOW_RUN 16  // columns per signature, must divide DISPLAY_WIDTH
     /* TODO: define font */
 #define FONT  ssd1306oled_font  // Refer font-name at font.h
     
@@ -134,10 +141,19 @@ void oled_flip(uint8_t flipping);  // flip display,
     uint8_t oled_drawCircle(uint8_t center_x, uint8_t center_y, uint8_t radius, uint8_t color);
     uint8_t oled_fillCircle(uint8_t center_x, uint8_t center_y, uint8_t radius, uint8_t color);
     uint8_t oled_drawBitmap(uint8_t x, uint8_t y, const uint8_t picture[], uint8_t width, uint8_t height, uint8_t color);
+    uint8_t oled_drawColumns(uint8_t x, uint8_t line, const uint8_t columns[], uint8_t width); // copy page columns from flash to a display line
     void oled_display(void);       // copy buffer to display RAM
+    void oled_flush_dirty(void);   // copy only the changed part of every page to display RAM
+    uint8_t oled_flush_async(void); // queue the changed parts on the TWI and return, 1 if the last flush is still running
+    uint8_t oled_flush_busy(void);  // 1 while an oled_flush_async() is on the bus
+                        // a transaction refused by a full TWI queue is resubmitted only by
+                        // oled_flush_busy() (oled_flush_async() calls it), so keep calling either
+                        // until the flush ends, eg. from a periodic display task
     void oled_clear_buffer(void);  // clear display buffer
     uint8_t oled_check_buffer(uint8_t x, uint8_t y); // read a pixel value from the display buffer
     void oled_display_block(uint8_t x, uint8_t line, uint8_t width); // display (part of) a display line
+    void oled_display_window(uint8_t x, uint8_t line, uint8_t width, uint8_t lines); // display a rectangle of lines
+                        // with one addressing header, SH1106 addresses every line
 #endif
 
 #ifdef __cplusplus
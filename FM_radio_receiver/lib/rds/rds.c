@@ -0,0 +1,235 @@
+ /**
+  * @file rds.c
+  * @defgroup rds RDS Decoder Library <rds.c>
+  * @code #include <rds.h> @endcode
+  * 
+  * @brief RDS (Radio Data System) group decoder implementation
+  */
+
+#include "rds.h"
+
+// group type codes, (group number << 1) | version B bit
+#define GROUP_0A 0x00
+#define GROUP_0B 0x01
+#define GROUP_2A 0x04
+#define GROUP_2B 0x05
+#define GROUP_4A 0x08
+
+/*
+ * Function for filling a text field with spaces
+ */
+static void clear_text(char *text, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) text[i] = ' ';
+    text[len] = '\0';
+}
+
+/*
+ * Function for storing one text character, unprintable characters are ignored
+ *
+ * returns:
+ * 1 if the stored character differs from the old one
+ */
+static uint8_t put_char(char *text, uint8_t pos, char c) {
+    if (c < 32 || c > 126) return 0;
+    if (text[pos] == c) return 0;
+    text[pos] = c;
+    return 1;
+}
+
+/*
+ * Function for counting identical receptions of one PS character
+ *
+ * returns:
+ * 1 if the character is confirmed and differs from the displayed one
+ */
+static uint8_t vote_ps_char(RdsInfo *rdsInfo, uint8_t pos, char c) {
+    if (c != rdsInfo->psCandidate[pos]) {
+        rdsInfo->psCandidate[pos] = c;
+        rdsInfo->psHits[pos] = 0;
+    }
+    if (rdsInfo->psHits[pos] < RDS_CONFIRM) rdsInfo->psHits[pos]++;
+    if (rdsInfo->psHits[pos] < RDS_CONFIRM) return 0;
+
+    return put_char(rdsInfo->stationName, pos, c);
+}
+
+/*
+ * Function for decoding the PS name segment of groups 0A/0B
+ */
+static void decode_ps(RdsInfo *rdsInfo, uint16_t blockB, uint16_t blockD) {
+    uint8_t textOffset = (blockB & 0x03) * 2;
+    uint8_t changed = 0;
+
+    // TA flag is only carried by group 0 (and 15B)
+    uint8_t flags = rdsInfo->flags & ~RDS_FLAG_TA;
+    if (blockB & (1 << 4)) flags |= RDS_FLAG_TA;
+    if (flags != rdsInfo->flags) {
+        rdsInfo->flags = flags;
+        rdsInfo->updated |= RDS_UPD_PTY;
+    }
+
+    changed |= vote_ps_char(rdsInfo, textOffset, blockD >> 8);
+    changed |= vote_ps_char(rdsInfo, textOffset + 1, blockD & 0xFF);
+
+    if (changed) {
+        rdsInfo->updated |= RDS_UPD_PS;
+        rdsInfo->ready = 1;
+    }
+}
+
+/*
+ * Function for decoding the RadioText segment of groups 2A (4 chars) and 2B (2 chars),
+ * the segment is written only after RDS_CONFIRM identical receptions
+ */
+static void decode_rt(RdsInfo *rdsInfo, uint8_t versionB, uint16_t blockB, uint16_t blockC, uint16_t blockD) {
+    uint8_t segment = blockB & 0x0F;
+    uint8_t ab = (blockB & (1 << 4)) ? RDS_FLAG_RT_AB : 0;
+    char chars[4];
+    uint8_t count;
+    uint8_t changed = 0;
+
+    // A/B flag toggles when the station starts a new text
+    if ((rdsInfo->flags & RDS_FLAG_RT_AB) != ab) {
+        rdsInfo->flags ^= RDS_FLAG_RT_AB;
+        clear_text(rdsInfo->radioText, RDS_RT_LEN);
+        for (uint8_t i = 0; i < RDS_RT_SEGMENTS; i++) rdsInfo->rtHits[i] = 0;
+        changed = 1;
+    }
+
+    if (versionB) {
+        chars[0] = blockD >> 8;
+        chars[1] = blockD & 0xFF;
+        count = 2;
+        blockC = 0;
+    } else {
+        chars[0] = blockC >> 8;
+        chars[1] = blockC & 0xFF;
+        chars[2] = blockD >> 8;
+        chars[3] = blockD & 0xFF;
+        count = 4;
+    }
+
+    // one vote slot per segment, 2A and 2B texts both have RDS_RT_SEGMENTS segments
+    uint16_t signature = blockC ^ ((blockD << 7) | (blockD >> 9));
+    if (signature != rdsInfo->rtCandidate[segment] || rdsInfo->rtHits[segment] == 0) {
+        rdsInfo->rtCandidate[segment] = signature;
+        rdsInfo->rtHits[segment] = 0;
+    }
+    if (rdsInfo->rtHits[segment] < RDS_CONFIRM) rdsInfo->rtHits[segment]++;
+
+    if (rdsInfo->rtHits[segment] >= RDS_CONFIRM) {
+        uint8_t pos = segment * count;
+        for (uint8_t i = 0; i < count; i++, pos++) {
+            if (chars[i] == '\r') {
+                // carriage return marks the end of a shorter text
+                if (rdsInfo->radioText[pos] != '\0') {
+                    rdsInfo->radioText[pos] = '\0';
+                    changed = 1;
+                }
+                break;
+            }
+            changed |= put_char(rdsInfo->radioText, pos, chars[i]);
+        }
+    }
+
+    if (changed) rdsInfo->updated |= RDS_UPD_RT;
+}
+
+/*
+ * Function for decoding the clock-time of group 4A into local hour and minute
+ */
+static void decode_ct(RdsInfo *rdsInfo, uint16_t blockC, uint16_t blockD) {
+    // UTC time in minutes of the day
+    int16_t minutes = (((blockC & 0x01) << 4) | (blockD >> 12)) * 60 + ((blockD >> 6) & 0x3F);
+
+    // local time offset in multiples of half hours, bit 5 is the sign
+    int16_t offset = (blockD & 0x1F) * 30;
+    if (blockD & 0x20) offset = -offset;
+
+    minutes += offset;
+    if (minutes < 0) minutes += 24 * 60;
+    if (minutes >= 24 * 60) minutes -= 24 * 60;
+
+    rdsInfo->hour = minutes / 60;
+    rdsInfo->minute = minutes % 60;
+    rdsInfo->flags |= RDS_FLAG_CT;
+    rdsInfo->updated |= RDS_UPD_CT;
+}
+
+/*
+ * Function for clearing all RDS fields
+ *
+ * args:
+ * pointer to RdsInfo structure
+ */
+void rds_clear(RdsInfo *rdsInfo) {
+    clear_text(rdsInfo->stationName, RDS_PS_LEN);
+    clear_text(rdsInfo->radioText, RDS_RT_LEN);
+    rdsInfo->pi = 0;
+    rdsInfo->pty = 0;
+    rdsInfo->flags = 0;
+    rdsInfo->hour = 0;
+    rdsInfo->minute = 0;
+    rdsInfo->ready = 0;
+    rdsInfo->updated = RDS_UPD_PS | RDS_UPD_RT | RDS_UPD_PI | RDS_UPD_PTY | RDS_UPD_CT;
+
+    for (uint8_t i = 0; i < RDS_PS_LEN; i++) {
+        rdsInfo->psCandidate[i] = 0;
+        rdsInfo->psHits[i] = 0;
+    }
+    for (uint8_t i = 0; i < RDS_RT_SEGMENTS; i++) {
+        rdsInfo->rtCandidate[i] = 0;
+        rdsInfo->rtHits[i] = 0;
+    }
+}
+
+/*
+ * Function for decoding one RDS group
+ *
+ * args:
+ * pointer to RdsInfo structure, blocks A to D of the group,
+ * block error rates packed as BLERA[7:6] BLERB[5:4] BLERC[3:2] BLERD[1:0]
+ */
+void rds_decode_group(RdsInfo *rdsInfo, const uint16_t blocks[4], uint8_t errors) {
+    uint16_t blockB = blocks[1];
+    uint8_t groupType = blockB >> 11;
+    uint8_t okC = RDS_BLER(errors, 2) <= RDS_MAX_BLER;
+    uint8_t okD = RDS_BLER(errors, 3) <= RDS_MAX_BLER;
+
+    // group type, PTY and TP come from block B, without it nothing is usable
+    if (RDS_BLER(errors, 1) > RDS_MAX_BLER) return;
+
+    // PI code is in block A of every group
+    if (RDS_BLER(errors, 0) <= RDS_MAX_BLER && blocks[0] != rdsInfo->pi) {
+        rdsInfo->pi = blocks[0];
+        rdsInfo->updated |= RDS_UPD_PI;
+    }
+
+    // PTY and TP are in block B of every group
+    uint8_t pty = (blockB >> 5) & 0x1F;
+    uint8_t flags = rdsInfo->flags & ~RDS_FLAG_TP;
+    if (blockB & (1 << 10)) flags |= RDS_FLAG_TP;
+    if (pty != rdsInfo->pty || flags != rdsInfo->flags) {
+        rdsInfo->pty = pty;
+        rdsInfo->flags = flags;
+        rdsInfo->updated |= RDS_UPD_PTY;
+    }
+
+    switch (groupType) {
+    case GROUP_0A:
+    case GROUP_0B:
+        if (okD) decode_ps(rdsInfo, blockB, blocks[3]);
+        break;
+    case GROUP_2A:
+        if (okC && okD) decode_rt(rdsInfo, 0, blockB, blocks[2], blocks[3]);
+        break;
+    case GROUP_2B:
+        if (okD) decode_rt(rdsInfo, 1, blockB, blocks[2], blocks[3]);
+        break;
+    case GROUP_4A:
+        if (okC && okD) decode_ct(rdsInfo, blocks[2], blocks[3]);
+        break;
+    default:
+        break;
+    }
+}
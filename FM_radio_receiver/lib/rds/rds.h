@@ -0,0 +1,90 @@
+ /**
+  * @file rds.h
+  * @defgroup rds RDS Decoder Library <rds.h>
+  * @code #include <rds.h> @endcode
+  * 
+  * @brief RDS (Radio Data System) group decoder
+  * 
+  * Decodes raw RDS groups (blocks A-D) into station information:
+  * programme service name (PS, groups 0A/0B), RadioText (RT, groups 2A/2B),
+  * clock-time (CT, group 4A), PI code, programme type (PTY) and the TA/TP flags.
+  * Every call decodes one group and only touches the fields carried by it.
+  * Blocks with too many bit errors are ignored and text characters have
+  * to be received several times before they are accepted.
+  * 
+  * The library does not access any hardware, the groups are delivered
+  * by the tuner driver (see si4703_update_rds()).
+  * @{
+  */
+
+#ifndef RDS_H
+#define RDS_H
+
+#include <stdint.h>
+
+// Length of the text fields without the null terminator
+#define RDS_PS_LEN 8
+#define RDS_RT_LEN 64
+#define RDS_RT_SEGMENTS 16 // address range of 2A and 2B segments
+
+// Error filtering, block error rate (BLER) levels reported by the tuner:
+// 0 = no errors, 1 = 1-2 errors corrected, 2 = 3-5 errors corrected, 3 = uncorrectable
+#ifndef RDS_MAX_BLER
+#define RDS_MAX_BLER 1  // blocks with a higher error level are ignored
+#endif
+#ifndef RDS_CONFIRM
+#define RDS_CONFIRM  2  // identical receptions needed before a PS/RT character is shown
+#endif
+#define RDS_BLER(_errors, _block) (((_errors) >> (6 - 2*(_block))) & 0x03) // _block 0-3 = A-D
+
+// RdsInfo.flags bits
+#define RDS_FLAG_TP    0x01 // traffic programme
+#define RDS_FLAG_TA    0x02 // traffic announcement in progress
+#define RDS_FLAG_RT_AB 0x04 // current RadioText A/B flag
+#define RDS_FLAG_CT    0x08 // hour and minute are valid
+
+// RdsInfo.updated bits, set by the decoder and cleared by the user
+#define RDS_UPD_PS  0x01
+#define RDS_UPD_RT  0x02
+#define RDS_UPD_PI  0x04
+#define RDS_UPD_PTY 0x08 // PTY, TA or TP changed
+#define RDS_UPD_CT  0x10
+
+// struct for keeping RDS (station info) data
+typedef struct {
+    char stationName[RDS_PS_LEN + 1]; // 8 characters + null terminator
+    char radioText[RDS_RT_LEN + 1];   // 64 characters + null terminator
+    uint16_t pi;         // programme identification code
+    uint8_t pty;         // programme type (0-31)
+    uint8_t flags;       // RDS_FLAG_* bits
+    uint8_t hour;        // local time from the last CT group
+    uint8_t minute;
+    uint8_t ready;       // data ready indicator
+    uint8_t updated;     // RDS_UPD_* bits of the fields changed since the user cleared it
+    // confirmation state of the decoder, a character is accepted after RDS_CONFIRM identical receptions
+    char psCandidate[RDS_PS_LEN];           // last received PS characters
+    uint8_t psHits[RDS_PS_LEN];             // identical receptions of psCandidate
+    uint16_t rtCandidate[RDS_RT_SEGMENTS];  // signature of the last received RT segments
+    uint8_t rtHits[RDS_RT_SEGMENTS];        // identical receptions of rtCandidate
+} RdsInfo;
+
+/**
+ * @brief Clears all RDS fields and the confirmation state, eg. after tuning to another station
+ * @param rdsInfo Pointer to RdsInfo structure
+ */
+void rds_clear(RdsInfo *rdsInfo);
+
+/**
+ * @brief Decodes one RDS group
+ * @param rdsInfo Pointer to RdsInfo structure
+ * @param blocks  Blocks A, B, C and D of the group
+ * @param errors  Block error levels packed as BLERA[7:6] BLERB[5:4] BLERC[3:2] BLERD[1:0]
+ * @note  PS and RadioText characters are written to rdsInfo only after
+ *        RDS_CONFIRM identical receptions, so a noisy signal does not
+ *        make the text flicker.
+ */
+void rds_decode_group(RdsInfo *rdsInfo, const uint16_t blocks[4], uint8_t errors);
+
+/** @} */
+
+#endif
@@ -8,6 +8,11 @@ static int16_t encoder_position = 0;
 static int8_t  encoder_delta    = 0;
 static uint8_t last_state       = 0;
 
+// velocity estimate, steps counted in windows of ENC_VELOCITY_MS
+static uint32_t window_start     = 0;
+static uint8_t  window_steps     = 0;
+static uint8_t  last_velocity    = 0;
+
 
 static const int8_t enc_transition_table[4][4] = {
     // new: 00, 01, 10, 11 (1,2,3,4)
@@ -34,6 +39,13 @@ void encoder_init(void)
     last_state = (clk << 1) | dt;
     encoder_position = 0;
     encoder_delta    = 0;
+    window_steps     = 0;
+    last_velocity    = 0;
+
+#if ENCODER_USE_PCINT
+    ENC_PCMSK |= (1 << ENC_CLK_PIN) | (1 << ENC_DT_PIN);
+    PCICR |= (1 << ENC_PCIE);
+#endif
 }
 
 void encoder_update(void)
@@ -50,32 +62,85 @@ void encoder_update(void)
     
     last_state = new_state;
 
+    if (diff != 0)
+    {
+        // close the window when it is over, an older one means the knob stood still
+        uint32_t now = hal_millis();
+        if (now - window_start >= ENC_VELOCITY_MS)
+        {
+            last_velocity = (now - window_start < 2 * ENC_VELOCITY_MS) ? window_steps : 0;
+            window_start  = now;
+            window_steps  = 0;
+        }
+        if (window_steps < 255) window_steps++;
+    }
+
     // DO NOT PRINT HERE USING UART.
 }
 
 
+#if ENCODER_USE_PCINT
+ISR(ENC_vect)
+{
+    encoder_update();
+}
+#endif
+
+
+
+// the state is shared with the interrupt, so it is read and reset atomically
 
 int16_t encoder_get_position(void)
 {
-    return encoder_position;
+    int16_t p;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        p = encoder_position;
+    }
+    return p;
 }
 
 
 void encoder_set_position(int16_t value)
 {
-    encoder_position = value;
-    encoder_delta    = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        encoder_position = value;
+        encoder_delta    = 0;
+    }
 }
 
 
 int8_t encoder_get_delta(void)
 {
-    int8_t d = encoder_delta;
-    encoder_delta = 0;
+    int8_t d;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        d = encoder_delta / ENC_STEPS_PER_DETENT;
+        encoder_delta -= d * ENC_STEPS_PER_DETENT;
+    }
     return d;
 }
 
 
+uint8_t encoder_get_velocity(void)
+{
+    uint32_t elapsed;
+    uint8_t steps, velocity;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        elapsed  = hal_millis() - window_start;
+        steps    = window_steps;
+        velocity = last_velocity;
+    }
+
+    if (elapsed >= 2 * ENC_VELOCITY_MS) return 0;
+    // the running window may already be faster than the last one
+    if (elapsed < ENC_VELOCITY_MS && velocity > steps) steps = velocity;
+    return steps / ENC_STEPS_PER_DETENT;
+}
+
+
 uint8_t encoder_button_pressed(void)
 {
     // Button is active-low
@@ -27,23 +27,43 @@
 #define ENC_SW_PINREG    PIND
 #define ENC_SW_PIN       4   // PD4
 
+// --- Decoding ---
+// 1: CLK and DT changes raise PCINT18/PCINT19, the library decodes them in its
+//    own interrupt and no transition is missed between timer ticks
+// 0: the application calls encoder_update() periodically
+#ifndef ENCODER_USE_PCINT
+#define ENCODER_USE_PCINT 1
+#endif
+#define ENC_PCMSK        PCMSK2
+#define ENC_PCIE         PCIE2
+#define ENC_vect         PCINT2_vect
+
+// window of the velocity estimate
+#define ENC_VELOCITY_MS  100
+
+// transitions of CLK/DT from one detent to the next, 4 on a KY-040
+#ifndef ENC_STEPS_PER_DETENT
+#define ENC_STEPS_PER_DETENT 4
+#endif
+
 
 /**
  * Sets CLK, DT, SW as inputs with pull-ups (using gpio library)
  * Initializes internal state machine
+ * With ENCODER_USE_PCINT enables the pin change interrupt of CLK and DT
  */
 void encoder_init(void);
 
 
 /**
- * Call this often
+ * Call this often (only without ENCODER_USE_PCINT)
  * reads CLK/DT, decodes movement, and updates internal position.
  */
 void encoder_update(void);
 
 
 /**
- * Get current encoder position (signed).
+ * Get current encoder position (signed), in transitions.
  */
 int16_t encoder_get_position(void);
 
@@ -55,12 +75,19 @@ void encoder_set_position(int16_t value);
 
 
 /**
- * Get position delta since last call.
- * Internally stored delta is reset to zero.
+ * Get position delta since last call, in whole detents.
+ * The transitions of a detent not yet completed are kept for the next call.
  */
 int8_t encoder_get_delta(void);
 
 
+/**
+ * Get turning speed in detents per ENC_VELOCITY_MS.
+ * Counted over the last complete window, 0 when the knob stands still.
+ */
+uint8_t encoder_get_velocity(void);
+
+
 /**
  * return 1 if button is pressed, 0 if released.
  * needs debouncing in user code.
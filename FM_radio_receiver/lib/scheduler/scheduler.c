@@ -0,0 +1,67 @@
+ /**
+  * @file scheduler.c
+  * @defgroup scheduler Cooperative Scheduler <scheduler.c>
+  * @code #include <scheduler.h> @endcode
+  *
+  * @brief Tick-based cooperative scheduler for the main loop
+  */
+
+#include "hal.h"
+#include "scheduler.h"
+
+static SchedTask *taskTable;
+static uint8_t taskCount;
+
+/*
+ * Function for initializing the task table
+ */
+void sched_init(SchedTask *tasks, uint8_t count) {
+    uint32_t now = hal_millis();
+
+    taskTable = tasks;
+    taskCount = count;
+    for (uint8_t i = 0; i < count; i++) {
+        tasks[i].deadline = now;
+        tasks[i].ready = 0;
+        tasks[i].overruns = 0;
+        tasks[i].maxTime = 0;
+    }
+}
+
+/*
+ * Function for running the first due task of the table
+ */
+uint8_t sched_run(void) {
+    uint32_t now = hal_millis();
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        SchedTask *task = &taskTable[i];
+
+        // the subtraction keeps working when hal_millis() wraps around
+        uint8_t due = (int32_t)(now - task->deadline) >= 0;
+        if (!due && !task->ready) continue;
+
+        // a triggered run does not move the periodic ones
+        task->ready = 0;
+        if (due) {
+            task->deadline += task->period;
+            // a task that fell behind by more than a period skips the missed runs
+            if ((int32_t)(now - task->deadline) >= 0) task->deadline = now + task->period;
+        }
+
+        task->run();
+
+        uint32_t time = hal_millis() - now;
+        if (time > task->maxTime) task->maxTime = time > 0xFFFF ? 0xFFFF : time;
+        if (time > task->budget) task->overruns++;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Function for requesting a run of a task at the next pass
+ */
+void sched_trigger(uint8_t id) {
+    if (id < taskCount) taskTable[id].ready = 1;
+}
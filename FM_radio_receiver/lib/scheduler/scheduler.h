@@ -0,0 +1,56 @@
+ /**
+  * @file scheduler.h
+  * @defgroup scheduler Cooperative Scheduler <scheduler.h>
+  * @code #include <scheduler.h> @endcode
+  *
+  * @brief Tick-based cooperative scheduler for the main loop
+  *
+  * The application keeps a table of tasks, each with a period, the time of
+  * its next run (deadline) and a run budget. sched_run() is called from the
+  * main loop and runs one task that is due, the table order is the priority:
+  * when more tasks are due the one with the lower index runs first. Every
+  * task runs to completion, so the worst-case latency of a task is the
+  * longest run of any other task, which the budgets make visible.
+  *
+  * Time comes from hal_millis(), advanced by the Timer0 overflow interrupt
+  * in 4 ms steps on the board.
+  * @{
+  */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+typedef struct {
+    void (*run)(void);      // task function, must not block
+    uint16_t period;        // ms between two runs
+    uint16_t budget;        // ms one run may take, longer runs are counted as overruns
+    uint32_t deadline;      // hal_millis() of the next run
+    uint8_t ready;          // run at the next pass, set by sched_trigger()
+    uint16_t overruns;      // runs longer than the budget
+    uint16_t maxTime;       // longest run in ms
+} SchedTask;
+
+/**
+ * @brief Starts the scheduler with a task table, every task is due right away
+ * @param tasks table of tasks ordered by priority, the first one is the most important
+ * @param count number of tasks
+ */
+void sched_init(SchedTask *tasks, uint8_t count);
+
+/**
+ * @brief Runs the most important task that is due
+ * @return 1 if a task ran, 0 if none was due
+ */
+uint8_t sched_run(void);
+
+/**
+ * @brief Makes a task due at the next pass regardless of its period
+ * @param id index of the task in the table
+ */
+void sched_trigger(uint8_t id);
+
+/** @} */
+
+#endif
@@ -10,8 +10,11 @@
 #include "si4703.h"
 #include "twi.h"
 #include "gpio.h"
-#include <util/delay.h>
-#include "uart.h"
+#include "hal.h"
+#include <string.h>
+#ifdef __AVR__
+#include "uart.h"   // the HAL provides uart_puts() on a host
+#endif
 
 // buffer definitions
 static uint8_t si4703_regs[32];         // I2C receive buffer 
@@ -19,48 +22,215 @@ static uint16_t shadow_regs[16];        // Si4703 register state-keeping variabl
 static volatile uint8_t *g_rst_port;    // pointer to port containing Si4703 RST pin
 static uint8_t g_rst_pin;               // Si4703 RST pin variable
 
+// tune/seek state machine
+#define OP_IDLE          0  // nothing running
+#define OP_WAIT_STC      1  // TUNE or SEEK bit set, waiting for STC = 1
+#define OP_WAIT_STC_CLR  2  // TUNE and SEEK bits cleared, waiting for STC = 0
+#define OP_POWERUP       3  // power-up sequence of si4703_reset_start() running
+
+// steps of the power-up sequence run by si4703_poll(), the index of the wait before the next one
+#define POWERUP_CRYSTAL    0
+#define POWERUP_ENABLE     1
+
+static volatile uint8_t op_state = OP_IDLE; // also read by the GPIO2 interrupt
+static uint8_t op_seek;                 // 1 for a seek, 0 for a tune
+static uint16_t op_polls;               // polls spent in the current state
+static uint8_t op_step;                 // POWERUP_* step done last
+static uint32_t op_since;               // hal_millis() of that step
+static Si4703Status op_result = SI4703_IDLE;
+static uint16_t tuning_channel;         // READCHAN seen by the last poll
+
+// latest target of si4703_request_freq(), taken over by si4703_poll()
+static uint16_t request_channel;
+static uint16_t op_channel;             // target of the running tune
+static uint8_t request_pending;
+static uint32_t request_since;          // hal_millis() when the target last changed
+
+// number of bytes read_registers_n() has to clock out for each purpose
+#define READ_STATUS  2          // 0x0A STATUSRSSI (RDSR, STC, SF, RSSI)
+#define READ_CHAN    4          // 0x0A-0x0B, adds READCHAN
+#define READ_RDS     12         // 0x0A-0x0F, adds RDSA-RDSD
+
+static volatile uint32_t bus_bytes;     // bytes moved over I2C by this driver
+static uint8_t dirty_regs;              // bit n set = shadow register n not written to the chip yet
+
+// GPIO2 interrupt flags, the chip pulses GPIO2 low on both STC and RDSR
+static volatile uint8_t stc_irq;        // STC may have been set
+#define STC_FALLBACK_POLLS 10           // poll STC every Nth call even without interrupt
+
+// raw RDS groups captured on the GPIO2 interrupt, decoded later by si4703_update_rds()
+typedef struct {
+    uint16_t blocks[4];                 // RDSA-RDSD
+    uint8_t errors;                     // BLERA[7:6] BLERB[5:4] BLERC[3:2] BLERD[1:0]
+} RdsGroup;
+
+static RdsGroup rds_ring[SI4703_RDS_RING];
+static volatile uint8_t rds_head;       // next free slot, written by the capture
+static volatile uint8_t rds_tail;       // oldest group, written by si4703_update_rds()
+static volatile uint16_t rds_received;  // groups stored into the ring
+static volatile uint16_t rds_dropped;   // groups lost before they could be stored
+
+static uint8_t rds_raw[READ_RDS];       // receive buffer of the capture transaction
+static void rds_capture_done(twi_xfer_t *xfer);
+static twi_xfer_t rds_xfer = {
+    .addr = SI4703_ADDR,
+    .rbuf = rds_raw, .rlen = sizeof(rds_raw),
+    .callback = rds_capture_done,
+};
+
 // Definice SDA pinu pro ATmega328P (Arduino Uno) - PC4
 #define SDA_PORT PORTC
 #define SDA_DDR  DDRC
 #define SDA_PIN  4
 
 /*
- * Function for writing the shadow registers onto the Si4703 chip
+ * Function for adding to the I2C traffic counter, also used from interrupts
  */
-static void read_registers(void) {
-    twi_start();
-    twi_write((SI4703_ADDR << 1) | TWI_READ);
-    // storing the read message into the buffer
-    for (uint8_t i = 0; i < 32; i++) {
-        si4703_regs[i] = twi_read((i == 31) ? TWI_NACK : TWI_ACK);
+static void count_bytes(uint8_t count) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        bus_bytes += count;
+    }
+}
+
+/*
+ * Function for storing one raw RDS group read from registers 0x0A-0x0F into the ring
+ */
+static void rds_push(const uint8_t *regs) {
+    if (!(regs[0] & 0x80)) return; // RDSR Ready bit
+
+    uint8_t next = (rds_head + 1) & (SI4703_RDS_RING - 1);
+    if (next == rds_tail) {
+        rds_dropped++;
+        return;
     }
-    twi_stop();
+
+    RdsGroup *group = &rds_ring[rds_head];
+    // RDSA-RDSD registers 0x0C-0x0F
+    for (uint8_t i = 0; i < 4; i++) {
+        group->blocks[i] = (regs[4 + 2*i] << 8) | regs[5 + 2*i];
+    }
+    // BLERA is in 0x0A[10:9], BLERB-BLERD in 0x0B[15:10]
+    group->errors = (((regs[0] >> 1) & 0x03) << 6) | (regs[2] >> 2);
+
+    rds_head = next;
+    rds_received++;
 }
 
 /*
- * Function for reading the registers from the Si4703 chip and updating the shadow registers
+ * Completion callback of the RDS capture transaction, runs in TWI_vect
  */
-static void write_registers(void) {
-    twi_start();
-    twi_write((SI4703_ADDR << 1) | TWI_WRITE);
+static void rds_capture_done(twi_xfer_t *xfer) {
+    count_bytes(1 + sizeof(rds_raw));
+    if (xfer->status == TWI_XFER_DONE) {
+        rds_push(rds_raw);
+    }
+}
+
+/*
+ * Function for reading the first count bytes of the register file from the Si4703 chip
+ * (the chip always starts reading at register 0x0A and wraps around,
+ * so si4703_regs[0] is the upper byte of 0x0A)
+ */
+static void read_registers_n(uint8_t count) {
+    twi_xfer_t xfer = {
+        .addr = SI4703_ADDR,
+        .rbuf = si4703_regs, .rlen = count,
+    };
+    twi_transfer(&xfer);
+    count_bytes(1 + count);     // address byte + data
+}
+
+/*
+ * Function for changing bits of a shadow register, the register is marked
+ * for the next si4703_commit() only if its value really changes
+ */
+static void update_reg(uint8_t reg, uint16_t mask, uint16_t bits) {
+    uint16_t val = (shadow_regs[reg] & ~mask) | bits;
+    if (val != shadow_regs[reg]) {
+        shadow_regs[reg] = val;
+        dirty_regs |= (1 << reg);
+    }
+}
+
+/*
+ * Function for writing the changed shadow registers onto the Si4703 chip
+ * (the chip always starts writing at register 0x02, so the transaction
+ * ends with the highest changed register)
+ */
+void si4703_commit(void) {
+    uint8_t buf[12];
+    uint8_t len = 0;
+
+    if (dirty_regs == 0) return;
 
     // registers 0x02 to 0x07 are writable
-    for (int reg = 0x02; reg <= 0x07; reg++) {
+    for (uint8_t reg = 0x02; reg <= 0x07 && (dirty_regs >> reg) != 0; reg++) {
         uint16_t val = shadow_regs[reg];
-        twi_write(val >> 8);   
-        twi_write(val & 0xFF); 
+        buf[len++] = val >> 8;
+        buf[len++] = val & 0xFF;
     }
-    twi_stop();
+    dirty_regs = 0;
+
+    twi_xfer_t xfer = {
+        .addr = SI4703_ADDR,
+        .wbuf = buf, .wlen = len,
+    };
+    twi_transfer(&xfer);
+    count_bytes(1 + len);
 }
 
 /*
- * Init routine according to AN230 programming manual table 3 (page 12)    
+ * GPIO2 interrupt, the pin change interrupt fires on both edges
  */
-void si4703_init(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t rst_pin) {
+#if SI4703_USE_GPIO2
+ISR(SI4703_INT_vect) {
+    if (!(SI4703_INT_PINREG & (1 << SI4703_INT_PIN))) {
+        stc_irq = 1;
+
+        // during a tune or seek the pulse is STC, no group of a settling tuner is read
+        if (op_state != OP_IDLE) return;
+
+        // read the group right away, the chip holds only one
+        if (rds_xfer.status == TWI_XFER_QUEUED || rds_xfer.status == TWI_XFER_BUSY) {
+            rds_dropped++;          // previous group is overwritten before it was read
+        } else if (twi_submit(&rds_xfer) != 0) {
+            rds_dropped++;          // bus queue is full
+        }
+    }
+}
+#endif
+
+/*
+ * Power-up sequence according to AN230 programming manual table 3 (page 12),
+ * split into the steps between its waits. si4703_init() waits with delays,
+ * si4703_reset_start() waits only for the reset pin (TWI is off meanwhile,
+ * nothing else may use the bus) and si4703_poll() runs the rest on hal_millis().
+ */
+
+/*
+ * Function for holding the chip in reset with SDA low, which selects the two-wire mode
+ */
+static void powerup_reset_low(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t rst_pin) {
     g_rst_port = rst_port;
     g_rst_pin = rst_pin;
+
+    // a hardware reset ends any running tune/seek operation
+    op_state = OP_IDLE;
+    op_result = SI4703_IDLE;
+    request_pending = 0;
+
+#if SI4703_USE_GPIO2
+    // GPIO2 floats during the reset
+    SI4703_INT_PCMSK &= ~(1 << SI4703_INT_PIN);
+#endif
+    rds_tail = rds_head;
+
+    // registers of the chip are back at their reset values
+    for (uint8_t reg = 0; reg < 16; reg++) shadow_regs[reg] = 0;
+    dirty_regs = 0;
     
-    // briefly disable I2C for pin control
+    // let pending transactions finish, then briefly disable I2C for pin control
+    while (twi_busy());
     TWCR &= ~(1 << TWEN);
 
     gpio_mode_output(rst_ddr, rst_pin);
@@ -70,18 +240,25 @@ void si4703_init(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t
     // force SDA to low 
     SDA_DDR |= (1 << SDA_PIN);
     SDA_PORT &= ~(1 << SDA_PIN);
-    
-    _delay_ms(10);
+}
 
+/*
+ * Function for releasing the reset, 10 ms after powerup_reset_low()
+ */
+static void powerup_reset_high(void) {
     // RST = 1 (chip start, Two-wire I2C mode is loaded)
-    gpio_write_high(rst_port, rst_pin);
-    
-    _delay_ms(10);
+    gpio_write_high(g_rst_port, g_rst_pin);
+}
 
+/*
+ * Function for starting the crystal, 10 ms after powerup_reset_high()
+ */
+static void powerup_crystal(void) {
     // re-enable I2C
     SDA_DDR &= ~(1 << SDA_PIN); 
     SDA_PORT |= (1 << SDA_PIN);
     twi_init();
+    twi_set_device_clock(SI4703_ADDR, F_SCL_FAST);
 
     uart_puts("DEBUG: HW reset finished.\r\n");
 
@@ -98,31 +275,36 @@ void si4703_init(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t
      * AHIZEN[14] bit set to 0 (disable Hi-Z audio output)
      * Reserved[13:0] set to 0x0100 to comply with datasheet in powerdown state
      */ 
-    shadow_regs[0x07] = 0x8100; // (Bit 15 XOSCEN = 1, BIT 14 AHIZEN = 0) | 0x0100
+    update_reg(0x07, 0xFFFF, 0x8100); // (Bit 15 XOSCEN = 1, BIT 14 AHIZEN = 0) | 0x0100
     
-    write_registers();
+    si4703_commit();
     
     uart_puts("DEBUG: Crystal enabled. Waiting for 500 ms...\r\n");
-    
-    _delay_ms(500); // crystal stabilization delay 
-
+}
 
+/*
+ * Function for powering the device up, 500 ms after powerup_crystal() (crystal stabilization)
+ */
+static void powerup_enable(void) {
     /*
      * set ENABLE[0] bit to 1 and DISABLE[0] bit to 0 in the POWERCFG (0x02) register
      * to put the device into powerup state
      */ 
-    shadow_regs[0x02] = 0xC001;
-    write_registers();
-
-    _delay_ms(120); // wait for device to powerup
+    update_reg(0x02, 0xFFFF, 0xC001);
+    si4703_commit();
+}
 
+/*
+ * Function for configuring the powered-up device, 120 ms after powerup_enable()
+ */
+static void powerup_configure(void) {
     /*
      * change the TEST1 (0x07) register to the powered-up form
      * XOSCEN[15] bit set to 1 (enable crystal)
      * AHIZEN[14] bit set to 0 (disable Hi-Z audio output)
      * Reserved[13:0] set to 0x3C04 to comply with datasheet in powerup state
      */ 
-    shadow_regs[0x07] = 0xBC04;
+    update_reg(0x07, 0xFFFF, 0xBC04);
 
 
     /*
@@ -131,81 +313,223 @@ void si4703_init(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t
      * SPACE[5:4] bits set to 0b01 (100kHz spacing)
      * VOLUME[3:0] set to 15 (Max)
      */ 
-    shadow_regs[0x05] = 0x001F; 
-    write_registers();
+    update_reg(0x05, 0xFFFF, 0x001F); 
+    si4703_commit();
 
     /*
      * Setting up the SYSCONFIG1 (0x04) register for the EU region
-     * RDS[12] bit set to 1 (enable interrupt)
+     * RDSIEN[15] bit set to 1 (GPIO2 pulse when a new RDS group is ready)
+     * STCIEN[14] bit set to 1 (GPIO2 pulse when seek/tune is complete)
+     * RDS[12] bit set to 1 (enable RDS)
      * DE[11] bit set to 1 (50 us de-emphasis used in EU)
+     * GPIO2[3:2] bits set to 0b01 (STC/RDS interrupt output)
      */ 
-    shadow_regs[0x04] = 0x1800; 
+    update_reg(0x04, 0xFFFF, 0xD804); 
 
-    write_registers();
+    /*
+     * Setting up the SYSCONFIG3 (0x06) register
+     * RDSM[11] bit set to 1 (verbose mode, block errors of all four blocks are reported)
+     */
+    update_reg(0x06, (1 << 11), (1 << 11));
+
+    si4703_commit();
+
+#if SI4703_USE_GPIO2
+    // GPIO2 is driven by the chip, pull-up only keeps the line defined before powerup
+    gpio_mode_input_pullup(&SI4703_INT_DDR, SI4703_INT_PIN);
+    SI4703_INT_PCMSK |= (1 << SI4703_INT_PIN);
+    PCICR |= (1 << SI4703_INT_PCIE);
+#endif
             
     uart_puts("DEBUG: Radio Enabled. Init OK.\r\n");
 }
 
 /*
- * Function for setting volume
+ * Init routine, waits for every step of the power-up sequence
+ */
+void si4703_init(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t rst_pin) {
+    powerup_reset_low(rst_port, rst_ddr, rst_pin);
+    _delay_ms(10);
+    powerup_reset_high();
+    _delay_ms(10);
+    powerup_crystal();
+    _delay_ms(500); // crystal stabilization delay 
+    powerup_enable();
+    _delay_ms(120); // wait for device to powerup
+    powerup_configure();
+}
+
+/*
+ * Function for starting the power-up sequence, si4703_poll() runs the rest
+ */
+void si4703_reset_start(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t rst_pin) {
+    powerup_reset_low(rst_port, rst_ddr, rst_pin);
+    _delay_ms(10);
+    powerup_reset_high();
+    _delay_ms(10);
+    powerup_crystal();
+    op_step = POWERUP_CRYSTAL;
+    op_since = hal_millis();
+    op_state = OP_POWERUP;
+}
+
+/*
+ * Function for running the power-up step that is due, the wait of a step
+ * is the time since the previous one
+ *
+ * returns:
+ * 1 when the device is powered up and configured
+ */
+static uint8_t powerup_poll(void) {
+    static const uint16_t wait_ms[] = { 500, 120 };
+
+    if (hal_millis() - op_since < wait_ms[op_step]) return 0;
+    op_since = hal_millis();
+
+    switch (op_step++) {
+    case POWERUP_CRYSTAL:    powerup_enable();     break;
+    default:                 // POWERUP_ENABLE
+        powerup_configure();
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Function for setting volume, written by the next si4703_commit()
  *
  * args:
  * volume - int value from 0 to 15
  */
 void si4703_set_volume(uint8_t volume) {
     if (volume > 15) volume = 15;
-    shadow_regs[0x05] &= 0xFFF0; 
-    shadow_regs[0x05] |= volume;
-    write_registers();
+    update_reg(0x05, 0x000F, volume);
 }
 
 /*
- * Function for setting frequency
+ * Function for muting the audio output, written by the next si4703_commit()
  *
  * args:
- * freq - frequency in MHz multiplied by 100 (eg. 87.5 MHz => 8750)
+ * mute - 1 to mute, 0 to unmute
  */
-void si4703_set_freq(uint16_t freq) {
+void si4703_set_mute(uint8_t mute) {
+    // DMUTE[14] bit set to 0 enables mute
+    update_reg(0x02, (1 << 14), mute ? 0 : (1 << 14));
+}
+
+/*
+ * Function for forcing mono output, written by the next si4703_commit()
+ *
+ * args:
+ * mono - 1 for mono, 0 for stereo
+ */
+void si4703_set_mono(uint8_t mono) {
+    // MONO[13] bit set to 1 forces mono
+    update_reg(0x02, (1 << 13), mono ? (1 << 13) : 0);
+}
+
+/*
+ * Function for clearing the TUNE and SEEK bits, which ends the operation
+ */
+static void op_stop(Si4703Status result) {
+    update_reg(0x03, (1 << 15), 0);     // clear TUNE
+    update_reg(0x02, (1 << 8), 0);      // clear SEEK
+    si4703_commit();
+
+    op_result = result;
+    op_polls = 0;
+    op_state = OP_WAIT_STC_CLR;
+}
+
+/*
+ * Function for finishing a running operation before a new one is started,
+ * a running power-up is waited for (main.c starts no seek or scan during it)
+ */
+static void op_abort(void) {
+    if (op_state == OP_WAIT_STC) {
+        op_stop(SI4703_CANCELLED);
+    }
+    while (si4703_poll() == SI4703_BUSY) {
+        _delay_ms(SI4703_POLL_MS);
+    }
+}
+
+/*
+ * Function for converting a frequency to a channel number of the band
+ */
+static uint16_t freq_to_channel(uint16_t freq) {
     if (freq < 8750) freq = 8750;
     if (freq > 10800) freq = 10800;
     
-    uint16_t channel = (freq - 8750) / 10;
-
-    shadow_regs[0x03] &= 0xFE00; 
-    shadow_regs[0x03] |= (1 << 15) | channel; // TUNE bit + Channel
-    write_registers();
-
-    // wait for STC
-    uint16_t timeout = 0;
-    while(1) {
-        read_registers();
-        if (si4703_regs[0] & 0x40) break; // STC bit
-        _delay_ms(10);
-        if (++timeout > 200) break; 
-    }
+    return (freq - 8750) / 10;
+}
 
-    shadow_regs[0x03] &= ~(1 << 15); // Clear TUNE
-    write_registers();
-    
-    // wait for STC
-    timeout = 0;
-    while(1) {
-        read_registers();
-        if (!(si4703_regs[0] & 0x40)) break; 
-        _delay_ms(10);
-        if (++timeout > 200) break;
+/*
+ * Function for setting the TUNE bit, the chip has to be idle
+ */
+static void op_tune(uint16_t channel) {
+    update_reg(0x03, (1 << 15) | 0x01FF, (1 << 15) | channel); // TUNE bit + Channel
+    si4703_commit();
+
+    tuning_channel = channel;
+    op_channel = channel;
+    op_seek = 0;
+    op_polls = 0;
+    op_state = OP_WAIT_STC;
+}
+
+/*
+ * Function for starting to tune the chosen frequency
+ *
+ * args:
+ * freq - frequency in MHz multiplied by 100 (eg. 87.5 MHz => 8750)
+ */
+void si4703_tune_start(uint16_t freq) {
+    // dropped first, op_abort() would otherwise start the pending tune
+    request_pending = 0;
+    op_abort();
+    op_tune(freq_to_channel(freq));
+}
+
+/*
+ * Function for storing the latest tune target, si4703_poll() tunes it
+ *
+ * args:
+ * freq - frequency in MHz multiplied by 100 (eg. 87.5 MHz => 8750)
+ */
+void si4703_request_freq(uint16_t freq) {
+    request_channel = freq_to_channel(freq);
+    request_since = hal_millis();
+    request_pending = 1;
+}
+
+/*
+ * Function for starting the requested tune once the target stopped changing
+ *
+ * returns:
+ * 1 while a request is pending or was just started, 0 without a request
+ */
+static uint8_t op_take_request(void) {
+    if (!request_pending) return 0;
+
+    if (hal_millis() - request_since >= SI4703_REQUEST_SETTLE_MS) {
+        request_pending = 0;
+        op_tune(request_channel);
     }
+    return 1;
 }
 
 /*
- * Function for finding the next available station
+ * Function for starting to seek the next available station
  *
  * args:
  * direction - SEEKUP or SEEKDOWN depending on the chosen direction
  */
-uint16_t si4703_seek(uint8_t direction) {
+void si4703_seek_start(uint8_t direction) {
+    request_pending = 0;
+    op_abort();
+
     // Nastavení podle AN230 Table 14 [cite: 592]
-    
 
     /*
      * Setting up the POWERCFG (0x02) register for seeking
@@ -214,41 +538,142 @@ uint16_t si4703_seek(uint8_t direction) {
      * SEEK[8] bit set to 1 to enable seeking
      */ 
 
-    shadow_regs[0x02] &= ~(1 << 10); 
+    update_reg(0x02, (1 << 10), 0); 
     
     if (direction == SEEK_UP) {
-        shadow_regs[0x02] |= (1 << 9);
+        update_reg(0x02, (1 << 9), (1 << 9));
     } else {
-        shadow_regs[0x02] &= ~(1 << 9);
+        update_reg(0x02, (1 << 9), 0);
     }
 
     // start seeking
-    shadow_regs[0x02] |= (1 << 8); 
-    write_registers();
-
-    // wait for STC (seek/tune complete bit)
-    uint16_t timeout = 0;
-    while(1) {
-        read_registers();
-        if (si4703_regs[0] & 0x40) break; 
-        _delay_ms(10);
-        if (++timeout > 500) { // 5s timeout
-             uart_puts("ERR: Seek timeout.\r\n");
-             break; 
+    update_reg(0x02, (1 << 8), (1 << 8)); 
+    si4703_commit();
+
+    op_seek = 1;
+    op_polls = 0;
+    op_state = OP_WAIT_STC;
+}
+
+/*
+ * Function for advancing the running tune/seek operation
+ *
+ * returns:
+ * SI4703_BUSY while running, final status once, then SI4703_IDLE
+ */
+Si4703Status si4703_poll(void) {
+    Si4703Status result;
+
+    switch (op_state) {
+    case OP_WAIT_STC:
+        // a newer target preempts the running operation
+        if (request_pending) {
+            if (op_seek || request_channel != op_channel) {
+                op_stop(SI4703_CANCELLED);
+                return SI4703_BUSY;
+            }
+            request_pending = 0;    // already being tuned
+        }
+        // without a GPIO2 pulse STC cannot be set yet, only check it now and then
+        if (!SI4703_USE_GPIO2 || stc_irq || (op_polls % STC_FALLBACK_POLLS) == 0) {
+            stc_irq = 0;
+            read_registers_n(READ_CHAN);
+            tuning_channel = ((si4703_regs[2] & 0x03) << 8) | si4703_regs[3];
+
+            // wait for STC (seek/tune complete bit)
+            if (si4703_regs[0] & 0x40) {
+                // SF bit is set when the seek did not find any station
+                op_stop((op_seek && (si4703_regs[0] & 0x20)) ? SI4703_SEEK_FAIL : SI4703_DONE);
+                return SI4703_BUSY;
+            }
+        }
+        if (++op_polls > (op_seek ? SI4703_SEEK_TIMEOUT_MS : SI4703_TUNE_TIMEOUT_MS) / SI4703_POLL_MS) {
+            if (op_seek) uart_puts("ERR: Seek timeout.\r\n");
+            op_stop(SI4703_TIMEOUT);
+        }
+        return SI4703_BUSY;
+
+    case OP_WAIT_STC_CLR:
+        // check if STC bit is back to 0
+        read_registers_n(READ_STATUS);
+        if ((si4703_regs[0] & 0x40) && ++op_polls <= SI4703_TUNE_TIMEOUT_MS / SI4703_POLL_MS) {
+            return SI4703_BUSY;
         }
+        op_state = OP_IDLE;
+        result = op_result;
+        op_result = SI4703_IDLE;
+        // the result of a preempted or superseded operation is not reported
+        if (op_take_request()) return SI4703_BUSY;
+        return result;
+
+    case OP_POWERUP:
+        if (!powerup_poll()) return SI4703_BUSY;
+        // the requested tune starts with the next poll, after the
+        // caller could set the volume over the defaults of the power-up
+        op_state = OP_IDLE;
+        return SI4703_DONE;
+
+    default:
+        if (op_take_request()) return SI4703_BUSY;
+        return SI4703_IDLE;
     }
+}
 
-    // disable seeking
-    shadow_regs[0x02] &= ~(1 << 8); 
-    write_registers();
-
-    // check if STC bit is back to 0
-    timeout = 0;
-    while(1) {
-        read_registers();
-        if (!(si4703_regs[0] & 0x40)) break; 
-        _delay_ms(10);
-        if (++timeout > 200) break;
+/*
+ * Function for stopping the running tune/seek operation
+ */
+void si4703_cancel(void) {
+    request_pending = 0;
+    if (op_state == OP_WAIT_STC) {
+        op_stop(SI4703_CANCELLED);
+    }
+}
+
+/*
+ * Function for returning the frequency seen by the last poll
+ *
+ * returns:
+ * Frequency in MHz multiplied by 100
+ */
+uint16_t si4703_get_tuning_freq(void) {
+    return (tuning_channel * 10) + 8750;
+}
+
+/*
+ * Function for returning the frequency the tuner ends on, the pending
+ * request when there is one
+ *
+ * returns:
+ * Frequency in MHz multiplied by 100
+ */
+uint16_t si4703_get_target_freq(void) {
+    if (request_pending) return (request_channel * 10) + 8750;
+    return si4703_get_tuning_freq();
+}
+
+/*
+ * Function for setting frequency, waits until the tuning is finished
+ *
+ * args:
+ * freq - frequency in MHz multiplied by 100 (eg. 87.5 MHz => 8750)
+ */
+void si4703_set_freq(uint16_t freq) {
+    si4703_tune_start(freq);
+    while (si4703_poll() == SI4703_BUSY) {
+        _delay_ms(SI4703_POLL_MS);
+    }
+}
+
+/*
+ * Function for finding the next available station, waits until the seek is finished
+ *
+ * args:
+ * direction - SEEKUP or SEEKDOWN depending on the chosen direction
+ */
+uint16_t si4703_seek(uint8_t direction) {
+    si4703_seek_start(direction);
+    while (si4703_poll() == SI4703_BUSY) {
+        _delay_ms(SI4703_POLL_MS);
     }
 
     return si4703_get_freq();
@@ -262,7 +687,7 @@ uint16_t si4703_seek(uint8_t direction) {
  * Frequency in MHz
  */
 uint16_t si4703_get_freq(void) {
-    read_registers();
+    read_registers_n(READ_CHAN);
     // Čteme kanál z registru 0B (READCHAN)
     uint16_t channel = ((si4703_regs[2] & 0x03) << 8) | si4703_regs[3];
     // Přepočet zpět: Freq = (Channel * 0.1) + 87.5
@@ -276,35 +701,86 @@ uint16_t si4703_get_freq(void) {
  * RSSI (0-127)
  */
 uint8_t si4703_get_rssi(void) {
-    read_registers();
+    // no signal to read before the power-up is over
+    if (op_state == OP_POWERUP) return 0;
+    read_registers_n(READ_STATUS);
     return si4703_regs[1]; // RSSI is stored in the bottom byte of the 0x0A register
 }
 
 /*
- * Function for returning the RSSI (signal strenght)
+ * Function for returning the stereo indicator of the last register read
+ */
+uint8_t si4703_get_stereo(void) {
+    return si4703_regs[0] & 0x01; // ST[8] of the 0x0A register
+}
+
+/*
+ * Function for reading a new RDS group and passing it to the RDS decoder
  *
  * args:
  * pointer to RdsInfo structure
  */
 void si4703_update_rds(RdsInfo *rdsInfo) {
-    read_registers();
-    if (si4703_regs[0] & 0x80) { // RDSR Ready bit
-        uint16_t blockB = (si4703_regs[6] << 8) | si4703_regs[7];
-        uint16_t blockD = (si4703_regs[10] << 8) | si4703_regs[11];
-        uint8_t groupType = (blockB & 0xF800) >> 11;
-        
-        // Group 0A or 0B contains the station name (PS)
-        if (groupType == 0 || groupType == 1) {
-            uint8_t textOffset = (blockB & 0x03) * 2; 
-            char char1 = (blockD >> 8) & 0xFF;
-            char char2 = (blockD) & 0xFF;
-
-            // Filtering unprintable characters
-            if (char1 >= 32 && char1 <= 126) rdsInfo->stationName[textOffset] = char1;
-            if (char2 >= 32 && char2 <= 126) rdsInfo->stationName[textOffset+1] = char2;
-            
-            rdsInfo->stationName[8] = '\0';
-            rdsInfo->ready = 1; 
-        }
+#if !SI4703_USE_GPIO2
+    // without the interrupt the group has to be polled here, RDSR stays set for
+    // a while, so a group equal to the one seen by the previous poll is skipped
+    static uint8_t last_blocks[READ_RDS - 4];
+    read_registers_n(READ_RDS);
+    if (memcmp(last_blocks, &si4703_regs[4], sizeof(last_blocks)) != 0) {
+        memcpy(last_blocks, &si4703_regs[4], sizeof(last_blocks));
+        rds_push(si4703_regs);
+    }
+#endif
+
+    // decode everything captured since the last call
+    while (rds_tail != rds_head) {
+        RdsGroup *group = &rds_ring[rds_tail];
+        rds_decode_group(rdsInfo, group->blocks, group->errors);
+        rds_tail = (rds_tail + 1) & (SI4703_RDS_RING - 1);
+    }
+}
+
+/*
+ * Function for returning the number of RDS groups stored for decoding
+ */
+uint16_t si4703_get_rds_received(void) {
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = rds_received;
+    }
+    return count;
+}
+
+/*
+ * Function for returning the number of RDS groups lost before they could be stored
+ */
+uint16_t si4703_get_rds_dropped(void) {
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        count = rds_dropped;
     }
-}
\ No newline at end of file
+    return count;
+}
+
+/*
+ * Function for returning the I2C traffic of the driver
+ *
+ * returns:
+ * number of bytes transferred, including the address bytes
+ */
+uint32_t si4703_get_bus_bytes(void) {
+    uint32_t bytes;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        bytes = bus_bytes;
+    }
+    return bytes;
+}
+
+/*
+ * Function for resetting the I2C traffic counter
+ */
+void si4703_reset_bus_bytes(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        bus_bytes = 0;
+    }
+}
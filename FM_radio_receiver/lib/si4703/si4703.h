@@ -20,6 +20,7 @@
 #define SI4703_H
 
 #include <stdint.h>
+#include "rds.h"
 
 // I2C address for Si4703
 #define SI4703_ADDR 0x10
@@ -28,15 +29,49 @@
 #define FREQ_MIN 8750
 #define FREQ_MAX 10800
 
+// Si4703 GPIO2 interrupt line (STC/RDS interrupt, active low), PB0 = Arduino D8
+#ifndef SI4703_USE_GPIO2
+#define SI4703_USE_GPIO2 1          // set to 0 if GPIO2 is not wired, registers are then polled
+#endif
+#ifndef SI4703_INT_PIN
+#define SI4703_INT_DDR    DDRB
+#define SI4703_INT_PINREG PINB
+#define SI4703_INT_PIN    PB0
+#define SI4703_INT_PCMSK  PCMSK0
+#define SI4703_INT_PCIE   PCIE0
+#define SI4703_INT_vect   PCINT0_vect
+#endif
+
+// Number of raw RDS groups buffered between captures and si4703_update_rds(), power of 2
+#ifndef SI4703_RDS_RING
+#define SI4703_RDS_RING 8
+#endif
+
 // Seeking directions
 #define SEEK_DOWN 0
 #define SEEK_UP   1
 
-// struct for keeping RDS (station info) data
-typedef struct {
-    char stationName[9]; // 8 characters + null terminator
-    uint8_t ready;       // data ready indicator
-} RdsInfo;
+// Tune/seek polling interval and timeouts
+#define SI4703_POLL_MS         10   // recommended interval between si4703_poll() calls
+#define SI4703_TUNE_TIMEOUT_MS 2000
+#define SI4703_SEEK_TIMEOUT_MS 5000
+
+// Time a requested target has to stay unchanged before its tune starts (si4703_request_freq()),
+// about one tune, so an encoder turned faster than the tuner follows costs no tunes in between
+#ifndef SI4703_REQUEST_SETTLE_MS
+#define SI4703_REQUEST_SETTLE_MS 70
+#endif
+
+// Tune/seek operation status returned by si4703_poll()
+typedef enum {
+    SI4703_IDLE,        // no operation running, nothing to report
+    SI4703_BUSY,        // tune or seek in progress
+    SI4703_DONE,        // tune or seek finished
+    SI4703_SEEK_FAIL,   // seek finished without finding a station
+    SI4703_TIMEOUT,     // STC bit did not come in time
+    SI4703_CANCELLED    // operation stopped by si4703_cancel()
+} Si4703Status;
+
 
 /**
  * @brief Si4703 module initialization
@@ -46,12 +81,49 @@ typedef struct {
  */
 void si4703_init(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t rst_pin);
 
+/**
+ * @brief Starts the module initialization, waits only for the 20 ms of the reset pin
+ * @param rst_port module RST pin port (eg. &PORTC)
+ * @param rst_ddr  module RST pin Data Direction Register (eg. &DDRC)
+ * @param rst_pin  module RST pin number (eg. PC0)
+ * @note  TWI is off while the reset pin selects the two-wire mode, so that
+ *        part blocks. si4703_poll() runs the other steps of si4703_init()
+ *        when their waits passed on hal_millis(), it returns SI4703_BUSY for
+ *        about 620 ms and SI4703_DONE once when the module is powered up,
+ *        si4703_get_rssi() returns 0 until then without a bus access. Settings made
+ *        before that are overwritten by the power-up defaults, a
+ *        si4703_request_freq() is tuned after it.
+ */
+void si4703_reset_start(volatile uint8_t *rst_port, volatile uint8_t *rst_ddr, uint8_t rst_pin);
+
 /**
  * @brief Output volume setting function
  * @param volume scale from 0 (silence) to 15 (max volume)
+ * @note  Takes effect after si4703_commit().
  */
 void si4703_set_volume(uint8_t volume);
 
+/**
+ * @brief Audio mute setting function
+ * @param mute 1 to mute the output, 0 to unmute it
+ * @note  Takes effect after si4703_commit().
+ */
+void si4703_set_mute(uint8_t mute);
+
+/**
+ * @brief Stereo/mono setting function
+ * @param mono 1 to force mono output, 0 for stereo
+ * @note  Takes effect after si4703_commit().
+ */
+void si4703_set_mono(uint8_t mono);
+
+/**
+ * @brief Writes the registers changed since the last commit onto the chip
+ * @note  Several setters can be called before one commit, they are then sent
+ *        in a single transaction that ends with the highest changed register.
+ */
+void si4703_commit(void);
+
 /**
  * @brief Tunes the module to the chosen frequency
  * @param freq Chosen frequency in MHz multiplied by 100 (94.8 MHz => 9480).
@@ -65,6 +137,63 @@ void si4703_set_freq(uint16_t freq);
  */
 uint16_t si4703_seek(uint8_t direction);
 
+/**
+ * @brief Starts tuning to the chosen frequency and returns immediately
+ * @param freq Chosen frequency in MHz multiplied by 100 (94.8 MHz => 9480).
+ * @note  A pending request is dropped and a running tune or seek is
+ *        cancelled first, a running power-up is waited for.
+ */
+void si4703_tune_start(uint16_t freq);
+
+/**
+ * @brief Requests tuning to a frequency without waiting for anything
+ * @param freq Chosen frequency in MHz multiplied by 100 (94.8 MHz => 9480).
+ * @note  Only the latest request is kept, a new one replaces the target.
+ *        si4703_poll() preempts a running tune or seek at once and starts
+ *        the tune of the latest target when it did not change for
+ *        SI4703_REQUEST_SETTLE_MS (hal_millis()), so a burst of requests
+ *        (eg. an encoder spin) costs only a few tunes.
+ *        si4703_poll() returns SI4703_BUSY while a request is pending, the
+ *        results of the preempted operations are not reported.
+ */
+void si4703_request_freq(uint16_t freq);
+
+/**
+ * @brief Starts seeking the next station and returns immediately
+ * @param direction SEEK_UP for a higher frequency or SEEK_DOWN for a lower frequency.
+ * @note  A pending request is dropped and a running tune or seek is
+ *        cancelled first, a running power-up is waited for.
+ */
+void si4703_seek_start(uint8_t direction);
+
+/**
+ * @brief Advances a running tune or seek operation
+ * @note  Has to be called every SI4703_POLL_MS milliseconds from the main loop
+ *        or a timer tick while the operation is running.
+ * @return SI4703_BUSY while running, the final status once when the operation
+ *         ends and SI4703_IDLE afterwards.
+ */
+Si4703Status si4703_poll(void);
+
+/**
+ * @brief Stops a running tune or seek operation
+ * @note  si4703_poll() reports SI4703_CANCELLED once the chip has acknowledged it.
+ */
+void si4703_cancel(void);
+
+/**
+ * @brief Returns the frequency seen by the last si4703_poll() call without bus access.
+ * @note  Useful for showing the progress of a seek.
+ */
+uint16_t si4703_get_tuning_freq(void);
+
+/**
+ * @brief Returns the target of a pending si4703_request_freq(), otherwise
+ *        the frequency seen by the last si4703_poll() call, without bus access.
+ * @note  Useful for coming back to the station the user chose.
+ */
+uint16_t si4703_get_target_freq(void);
+
 /**
  * @brief Reads the currently tuned frequency.
  */
@@ -76,13 +205,45 @@ uint16_t si4703_get_freq(void);
  */
 uint8_t si4703_get_rssi(void);
 
+/**
+ * @brief Returns the stereo indicator (1 = stereo) of the last register read without bus access.
+ * @note  Call it after si4703_get_rssi(), which reads the status register.
+ */
+uint8_t si4703_get_stereo(void);
+
 /**
  * @brief Function for handling RDS (station data)
- * @note  Has to be called in the main loop of the program.
+ * @note  Has to be called in the main loop of the program. With SI4703_USE_GPIO2
+ *        every group is read as soon as GPIO2 signals it and kept in a ring
+ *        buffer, this function then decodes all buffered groups.
  * @param rdsInfo Pointer to RdsInfo structure
  */
 void si4703_update_rds(RdsInfo *rdsInfo);
 
+/**
+ * @brief Returns the number of RDS groups captured for decoding
+ */
+uint16_t si4703_get_rds_received(void);
+
+/**
+ * @brief Returns the number of RDS groups lost before they could be captured
+ * @note  A group is lost when the next one arrives before it was read
+ *        or when the ring buffer is full.
+ */
+uint16_t si4703_get_rds_dropped(void);
+
+/**
+ * @brief Returns the number of bytes the driver has moved over I2C
+ * @note  Includes the address byte of every transaction, useful for
+ *        comparing the bus load of different driver strategies.
+ */
+uint32_t si4703_get_bus_bytes(void);
+
+/**
+ * @brief Resets the I2C byte counter to zero
+ */
+void si4703_reset_bus_bytes(void);
+
 /** @} */
 
 #endif
\ No newline at end of file
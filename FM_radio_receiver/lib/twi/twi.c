@@ -6,8 +6,31 @@
  * Tested on Arduino Uno board and ATmega328P, 16 MHz.
  */
 
+#ifdef __AVR__
+
 // -- Includes ---------------------------------------------
 #include <twi.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+
+// -- Transaction queue ------------------------------------
+static twi_xfer_t *volatile twi_queue[TWI_QUEUE_SIZE];
+static volatile uint8_t twi_head = 0;   // Index of the next free slot
+static volatile uint8_t twi_tail = 0;   // Index of the transaction on the bus
+static volatile uint8_t twi_active = 0; // TWI_vect owns the TWI unit
+static uint16_t twi_pos;                // Byte index within hdr+wbuf or rbuf
+static uint8_t twi_reading;             // Read phase of the current transaction
+static uint8_t twi_retried;             // Current transaction already fell back to slow clock
+
+// -- Speed profiles ---------------------------------------
+static uint8_t twi_default_rate = TWI_BIT_RATE_REG;
+static struct {
+    uint8_t addr;                       // Slave address, 0 for a free slot
+    uint8_t rate;                       // TWBR value used for this device
+} twi_speed[TWI_SPEED_SLOTS];
+
+static void twi_poll(void);
 
 
 // -- Functions --------------------------------------------
@@ -25,7 +48,101 @@ void twi_init(void)
 
     /* Set SCL frequency */
     TWSR &= ~((1<<TWPS1) | (1<<TWPS0));
-    TWBR = TWI_BIT_RATE_REG;
+    TWBR = twi_default_rate;
+}
+
+
+/*
+ * Function: twi_bit_rate()
+ * Purpose:  Convert SCL frequency to TWI bit rate register value.
+ * Input:    scl SCL frequency in Hz
+ * Returns:  TWBR value, limited to the range allowed in Master mode
+ */
+static uint8_t twi_bit_rate(uint32_t scl)
+{
+    uint32_t div = F_CPU / scl;
+
+    if (div < 16 + 2*TWI_BIT_RATE_MIN)
+        return TWI_BIT_RATE_MIN;
+    if (div > 16 + 2*255UL)
+        return 255;
+    return (div - 16) / 2;
+}
+
+
+/*
+ * Function: twi_device_rate()
+ * Purpose:  Look up TWI bit rate register value for one device.
+ * Input:    addr Slave address
+ * Returns:  TWBR value from the speed profile, or the default one
+ */
+static uint8_t twi_device_rate(uint8_t addr)
+{
+    for (uint8_t i = 0; i < TWI_SPEED_SLOTS; i++)
+    {
+        if (twi_speed[i].addr == addr)
+            return twi_speed[i].rate;
+    }
+    return twi_default_rate;
+}
+
+
+/*
+ * Function: twi_set_clock()
+ * Purpose:  Set the default SCL frequency.
+ * Input:    scl SCL frequency in Hz
+ * Returns:  none
+ */
+void twi_set_clock(uint32_t scl)
+{
+    twi_default_rate = twi_bit_rate(scl);
+    if (!twi_busy())
+        TWBR = twi_default_rate;
+}
+
+
+/*
+ * Function: twi_set_device_clock()
+ * Purpose:  Set SCL frequency of the queued transactions for one device.
+ * Input:    addr Slave address
+ *           scl SCL frequency in Hz
+ * Returns:  0 if stored, 1 if the profile table is full
+ */
+uint8_t twi_set_device_clock(uint8_t addr, uint32_t scl)
+{
+    uint8_t slot = TWI_SPEED_SLOTS;
+
+    for (uint8_t i = 0; i < TWI_SPEED_SLOTS; i++)
+    {
+        if (twi_speed[i].addr == addr)
+        {
+            slot = i;
+            break;
+        }
+        if (twi_speed[i].addr == 0 && slot == TWI_SPEED_SLOTS)
+            slot = i;
+    }
+    if (slot == TWI_SPEED_SLOTS)
+        return 1;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        twi_speed[slot].addr = addr;
+        twi_speed[slot].rate = twi_bit_rate(scl);
+    }
+    return 0;
+}
+
+
+/*
+ * Function: twi_get_device_clock()
+ * Purpose:  Get SCL frequency currently used for one device.
+ * Input:    addr Slave address
+ * Returns:  SCL frequency in Hz
+ */
+uint32_t twi_get_device_clock(uint8_t addr)
+{
+    return F_CPU / (16 + 2*(uint32_t)twi_device_rate(addr));
 }
 
 
@@ -36,6 +153,12 @@ void twi_init(void)
  */
 void twi_start(void)
 {
+    /* Let the interrupt-driven queue release the bus */
+    while (twi_busy())
+        twi_poll();
+    while (TWCR & (1<<TWSTO));
+    TWBR = twi_default_rate;
+
     /* Send Start condition */
     TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN);
     while ((TWCR & (1<<TWINT)) == 0);
@@ -156,3 +279,234 @@ void twi_readfrom_mem_into(uint8_t addr, uint8_t memaddr, volatile uint8_t *buf,
         twi_stop();
     }
 }
+
+
+/*
+ * Function: twi_finish()
+ * Purpose:  Close the current transaction, start the next queued one
+ *           or release the bus, and notify the owner of the descriptor.
+ * Input:    status TWI_XFER_DONE or TWI_XFER_NACK
+ * Returns:  none
+ */
+static void twi_finish(uint8_t status)
+{
+    twi_xfer_t *xfer = twi_queue[twi_tail];
+
+    twi_tail = (twi_tail + 1) & (TWI_QUEUE_SIZE - 1);
+    twi_pos = 0;
+    twi_reading = 0;
+    twi_retried = 0;
+
+    if (twi_tail != twi_head)
+    {
+        /* Stop followed by Start of the next transaction */
+        TWBR = twi_device_rate(twi_queue[twi_tail]->addr);
+        TWCR = (1<<TWINT) | (1<<TWSTO) | (1<<TWSTA) | (1<<TWEN) | (1<<TWIE);
+    }
+    else
+    {
+        TWCR = (1<<TWINT) | (1<<TWSTO) | (1<<TWEN);
+        twi_active = 0;
+    }
+
+    xfer->status = status;
+    if (xfer->callback)
+        xfer->callback(xfer);
+}
+
+
+/*
+ * Function: twi_service()
+ * Purpose:  Advance the current transaction by one bus event. Called
+ *           from TWI_vect or by polling when interrupts are disabled.
+ * Returns:  none
+ */
+static void twi_service(void)
+{
+    twi_xfer_t *xfer = twi_queue[twi_tail];
+    uint8_t twi_status = TWSR & 0xf8;
+
+    switch (twi_status)
+    {
+    case 0x08:  // Start has been transmitted
+    case 0x10:  // Repeated Start has been transmitted
+        xfer->status = TWI_XFER_BUSY;
+        if (!twi_reading && (xfer->hlen + xfer->wlen) == 0 && xfer->rlen != 0)
+            twi_reading = 1;
+        TWDR = (xfer->addr<<1) | (twi_reading ? TWI_READ : TWI_WRITE);
+        TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWIE);
+        break;
+
+    case 0x18:  // SLA+W has been transmitted and ACK received
+    case 0x28:  // Data byte has been transmitted and ACK received
+        if (twi_pos < xfer->hlen)
+        {
+            TWDR = xfer->hdr[twi_pos++];
+            TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWIE);
+        }
+        else if (twi_pos < xfer->hlen + xfer->wlen)
+        {
+            TWDR = xfer->wbuf[twi_pos++ - xfer->hlen];
+            TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWIE);
+        }
+        else if (xfer->rlen != 0)
+        {
+            twi_pos = 0;
+            twi_reading = 1;
+            TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN) | (1<<TWIE);
+        }
+        else
+        {
+            twi_finish(TWI_XFER_DONE);
+        }
+        break;
+
+    case 0x40:  // SLA+R has been transmitted and ACK received
+        if (xfer->rlen > 1)
+            TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWEA) | (1<<TWIE);
+        else
+            TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWIE);
+        break;
+
+    case 0x50:  // Data byte has been received and ACK returned
+        xfer->rbuf[twi_pos++] = TWDR;
+        if (twi_pos < xfer->rlen - 1)
+            TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWEA) | (1<<TWIE);
+        else
+            TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWIE);
+        break;
+
+    case 0x58:  // Data byte has been received and NACK returned
+        xfer->rbuf[twi_pos] = TWDR;
+        twi_finish(TWI_XFER_DONE);
+        break;
+
+    case 0x38:  // Arbitration lost, try again once the bus is free
+        twi_pos = 0;
+        twi_reading = 0;
+        TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN) | (1<<TWIE);
+        break;
+
+    case 0x20:  // SLA+W has been transmitted and NACK received
+    case 0x48:  // SLA+R has been transmitted and NACK received
+        if (!twi_retried && TWBR < twi_default_rate)
+        {
+            /* Device is not able to run fast, use default clock from now on */
+            for (uint8_t i = 0; i < TWI_SPEED_SLOTS; i++)
+            {
+                if (twi_speed[i].addr == xfer->addr)
+                    twi_speed[i].rate = twi_default_rate;
+            }
+            twi_retried = 1;
+            twi_pos = 0;
+            twi_reading = 0;
+            TWBR = twi_default_rate;
+            TWCR = (1<<TWINT) | (1<<TWSTO) | (1<<TWSTA) | (1<<TWEN) | (1<<TWIE);
+        }
+        else
+        {
+            twi_finish(TWI_XFER_NACK);
+        }
+        break;
+
+    default:    // 0x30: NACK received after data byte, 0x00: bus error
+        twi_finish(TWI_XFER_NACK);
+        break;
+    }
+}
+
+
+/*
+ * Function: twi_poll()
+ * Purpose:  Service the TWI unit by polling when global interrupts are
+ *           disabled and TWI_vect cannot run.
+ * Returns:  none
+ */
+static void twi_poll(void)
+{
+    if (!(SREG & (1<<SREG_I)) && twi_active && (TWCR & (1<<TWINT)))
+        twi_service();
+}
+
+
+/*
+ * Function: TWI_vect
+ * Purpose:  Drive the queued transactions byte by byte.
+ */
+ISR(TWI_vect)
+{
+    twi_service();
+}
+
+
+/*
+ * Function: twi_submit()
+ * Purpose:  Append one transaction to the queue and start the bus if
+ *           it is idle.
+ * Input:    xfer Transaction descriptor
+ * Returns:  0 if queued, 1 if the queue is full
+ */
+uint8_t twi_submit(twi_xfer_t *xfer)
+{
+    uint8_t full = 0;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint8_t next = (twi_head + 1) & (TWI_QUEUE_SIZE - 1);
+
+        if (next == twi_tail)
+        {
+            full = 1;
+        }
+        else
+        {
+            xfer->status = TWI_XFER_QUEUED;
+            twi_queue[twi_head] = xfer;
+            twi_head = next;
+
+            if (!twi_active)
+            {
+                twi_active = 1;
+                twi_pos = 0;
+                twi_reading = 0;
+                twi_retried = 0;
+                while (TWCR & (1<<TWSTO));
+                TWBR = twi_device_rate(xfer->addr);
+                TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN) | (1<<TWIE);
+            }
+        }
+    }
+
+    return full;
+}
+
+
+/*
+ * Function: twi_busy()
+ * Purpose:  Test whether the transaction queue is working.
+ * Returns:  1 if a transaction is queued or in progress, 0 otherwise
+ */
+uint8_t twi_busy(void)
+{
+    return twi_active;
+}
+
+
+/*
+ * Function: twi_transfer()
+ * Purpose:  Queue one transaction and wait for its completion.
+ * Input:    xfer Transaction descriptor
+ * Returns:  0 if the transaction has been acknowledged, 1 otherwise
+ */
+uint8_t twi_transfer(twi_xfer_t *xfer)
+{
+    while (twi_submit(xfer) != 0)
+        twi_poll();
+
+    while (xfer->status == TWI_XFER_QUEUED || xfer->status == TWI_XFER_BUSY)
+        twi_poll();
+
+    return (xfer->status == TWI_XFER_DONE) ? 0 : 1;
+}
+
+#endif
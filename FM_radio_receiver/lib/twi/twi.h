@@ -19,13 +19,22 @@
  * This library defines functions for the TWI (I2C) communication between
  * AVR and Slave device(s). Functions use internal TWI module of AVR.
  *
+ * Besides the blocking byte-level functions, the library contains an
+ * interrupt-driven transaction engine. A transaction is described by
+ * a twi_xfer_t descriptor and queued by twi_submit(); bytes are then
+ * moved by the TWI_vect interrupt while the main loop keeps running.
+ *
+ * On a host PC (see hal.h) the same functions are provided by twi_host.c,
+ * which delivers the bytes to simulated devices.
+ *
  * @note Only Master transmitting and Master receiving modes are implemented. Based on Microchip Atmel ATmega16 and ATmega328P manuals.
  * @copyright (c) 2018-2025 Tomas Fryza, MIT license
  * @{
  */
 
 // -- Includes ---------------------------------------------
- #include <avr/io.h>
+ #include <hal.h>
+ #include <stdint.h>
 
 
 // -- Defines ----------------------------------------------
@@ -35,8 +44,16 @@
 #ifndef F_CPU
 #define F_CPU 16000000 /**< @brief CPU frequency in Hz required TWI_BIT_RATE_REG */
 #endif
-#define F_SCL 100000 /**< @brief I2C/TWI bit rate. Must be greater than 31000 */
-#define TWI_BIT_RATE_REG ((F_CPU/F_SCL - 16) / 2) /**< @brief TWI bit rate register value */
+#ifndef F_SCL
+#define F_SCL 100000 /**< @brief Default I2C/TWI bit rate. Must be greater than 31000 */
+#endif
+#define F_SCL_FAST 400000 /**< @brief Fast-mode I2C/TWI bit rate */
+#define TWI_BIT_RATE(_scl) ((F_CPU/(_scl) - 16) / 2) /**< @brief TWI bit rate register value for SCL frequency _scl */
+#define TWI_BIT_RATE_REG TWI_BIT_RATE(F_SCL) /**< @brief TWI bit rate register value */
+#define TWI_BIT_RATE_MIN 10 /**< @brief Smallest TWI bit rate register value allowed in Master mode */
+#ifndef TWI_SPEED_SLOTS
+#define TWI_SPEED_SLOTS 4 /**< @brief Number of devices with their own SCL frequency */
+#endif
 
 
 /**
@@ -58,6 +75,40 @@
 #define PIN(_x) (*(&_x - 2)) /**< @brief Address of input register of port _x */
 
 
+/**
+ * @name Definitions for the transaction queue
+ */
+#ifndef TWI_QUEUE_SIZE
+#define TWI_QUEUE_SIZE 4 /**< @brief Number of queued transactions, must be power of 2 */
+#endif
+#define TWI_XFER_IDLE 0 /**< @brief Descriptor has not been submitted yet */
+#define TWI_XFER_QUEUED 1 /**< @brief Descriptor waits in the queue */
+#define TWI_XFER_BUSY 2 /**< @brief Transaction is in progress on the bus */
+#define TWI_XFER_DONE 3 /**< @brief Transaction finished, all bytes were acknowledged */
+#define TWI_XFER_NACK 4 /**< @brief Transaction aborted, NACK or bus error received */
+
+
+// -- Types ------------------------------------------------
+/**
+ * @brief  Descriptor of one queued I2C/TWI transaction.
+ * @note   The write phase sends hdr followed by wbuf, the read phase
+ *         then fills rbuf after a repeated Start. Either phase may be
+ *         empty. All buffers and the descriptor itself must stay valid
+ *         until status becomes TWI_XFER_DONE or TWI_XFER_NACK.
+ */
+typedef struct twi_xfer {
+    uint8_t addr;           /**< @brief 7-bit slave address */
+    const uint8_t *hdr;     /**< @brief Header bytes, such as control or register byte */
+    uint8_t hlen;           /**< @brief Number of header bytes */
+    const uint8_t *wbuf;    /**< @brief Data bytes to be written */
+    uint16_t wlen;          /**< @brief Number of data bytes to be written */
+    uint8_t *rbuf;          /**< @brief Buffer for the bytes to be read */
+    uint8_t rlen;           /**< @brief Number of bytes to be read */
+    volatile uint8_t status; /**< @brief One of TWI_XFER_* values */
+    void (*callback)(struct twi_xfer *xfer); /**< @brief Called from TWI_vect when done, may be NULL */
+} twi_xfer_t;
+
+
 // -- Function prototypes ----------------------------------
 /**
  * @brief  Initialize TWI unit, enable internal pull-ups, and set SCL frequency.
@@ -128,6 +179,71 @@ uint8_t twi_test_address(uint8_t addr);
  */
 void twi_readfrom_mem_into(uint8_t addr, uint8_t memaddr, volatile uint8_t *buf, uint8_t nbytes);
 
+
+/**
+ * @brief  Set the default SCL frequency used by the blocking functions
+ *         and by devices without their own speed profile.
+ * @param  scl SCL frequency in Hz, such as F_SCL or F_SCL_FAST
+ * @return none
+ */
+void twi_set_clock(uint32_t scl);
+
+
+/**
+ * @brief  Set SCL frequency of the queued transactions for one device.
+ * @param  addr Slave address
+ * @param  scl SCL frequency in Hz, such as F_SCL_FAST
+ * @return Table status
+ * @retval 0 - Speed profile has been stored
+ * @retval 1 - All TWI_SPEED_SLOTS profiles are used by other devices
+ * @note   If the device does not acknowledge its address at a higher
+ *         frequency than the default one, the queue retries the
+ *         transaction at the default frequency and keeps using it.
+ */
+uint8_t twi_set_device_clock(uint8_t addr, uint32_t scl);
+
+
+/**
+ * @brief  Get SCL frequency currently used for one device.
+ * @param  addr Slave address
+ * @return SCL frequency in Hz
+ */
+uint32_t twi_get_device_clock(uint8_t addr);
+
+
+/**
+ * @brief  Append one transaction to the interrupt-driven queue and
+ *         start the bus if it is idle.
+ * @param  xfer Transaction descriptor
+ * @return Queue status
+ * @retval 0 - Transaction has been queued
+ * @retval 1 - Queue is full, transaction has not been queued
+ * @note   Can be called from an interrupt routine, including the
+ *         completion callback of another transaction.
+ */
+uint8_t twi_submit(twi_xfer_t *xfer);
+
+
+/**
+ * @brief  Test whether the transaction queue is working.
+ * @return Queue state
+ * @retval 0 - Queue is empty and the bus is released
+ * @retval 1 - At least one transaction is queued or in progress
+ */
+uint8_t twi_busy(void);
+
+
+/**
+ * @brief  Queue one transaction and wait for its completion.
+ * @param  xfer Transaction descriptor
+ * @return ACK/NACK received value
+ * @retval 0 - Transaction has been acknowledged
+ * @retval 1 - NACK or bus error has been received
+ * @note   Works with global interrupts disabled as well, the TWI unit
+ *         is then serviced by polling.
+ */
+uint8_t twi_transfer(twi_xfer_t *xfer);
+
 /** @} */
 
 #endif
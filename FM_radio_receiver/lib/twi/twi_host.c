@@ -0,0 +1,431 @@
+/*
+ * Host backend of the I2C/TWI library.
+ *
+ * Replaces twi.c when the libraries are built for a PC, see twi_host.h.
+ */
+
+#ifndef __AVR__
+
+// -- Includes ---------------------------------------------
+#include <twi_host.h>
+#include <hal.h>
+#include <stddef.h>
+
+
+// -- Simulated bus ----------------------------------------
+static const twi_host_device_t *twi_devices[128];
+static const twi_host_device_t *twi_dev;  // Device addressed by the current transaction
+static uint8_t twi_sla_phase;             // Next byte written is SLA+R/W
+static uint8_t twi_rate;                  // TWBR value of the current transaction
+static twi_host_stats_t twi_stats;
+
+// -- Transaction queue ------------------------------------
+static twi_xfer_t *twi_queue[TWI_QUEUE_SIZE];
+static uint8_t twi_head = 0;    // Index of the next free slot
+static uint8_t twi_tail = 0;    // Index of the transaction on the bus
+static uint8_t twi_active = 0;  // Queue is being drained
+
+// -- Speed profiles ---------------------------------------
+static uint8_t twi_default_rate = TWI_BIT_RATE_REG;
+static struct {
+    uint8_t addr;               // Slave address, 0 for a free slot
+    uint8_t rate;               // TWBR value used for this device
+} twi_speed[TWI_SPEED_SLOTS];
+
+
+// -- Functions --------------------------------------------
+/*
+ * Function: twi_bus_clocks()
+ * Purpose:  Account for SCL clocks at the current bit rate.
+ * Input:    clocks Number of SCL periods
+ * Returns:  none
+ */
+static void twi_bus_clocks(uint16_t clocks)
+{
+    uint32_t ns = (uint64_t)clocks * (16 + 2*(uint32_t)twi_rate) * 1000000000ULL / F_CPU;
+
+    twi_stats.bus_ns += ns;
+    hal_advance_ns(ns);
+}
+
+
+/*
+ * Function: twi_bus_start()
+ * Purpose:  (Repeated) Start condition, the next byte addresses a slave.
+ * Returns:  none
+ */
+static void twi_bus_start(void)
+{
+    twi_stats.transactions++;
+    twi_sla_phase = 1;
+    twi_bus_clocks(1);
+}
+
+
+/*
+ * Function: twi_bus_write()
+ * Purpose:  Move one byte from Master to the addressed device.
+ * Input:    data SLA+R/W or data byte
+ * Returns:  TWI_ACK or TWI_NACK
+ */
+static uint8_t twi_bus_write(uint8_t data)
+{
+    uint8_t ack = TWI_ACK;
+
+    twi_stats.bytes++;
+    twi_bus_clocks(9);
+
+    if (twi_sla_phase)
+    {
+        twi_sla_phase = 0;
+        twi_dev = twi_devices[data >> 1];
+        if (twi_dev == NULL)
+            ack = TWI_NACK;
+        else if (twi_dev->start)
+            ack = twi_dev->start(twi_dev->ctx, data & 1);
+        if (ack != TWI_ACK)
+            twi_dev = NULL;
+    }
+    else if (twi_dev == NULL)
+    {
+        ack = TWI_NACK;
+    }
+    else if (twi_dev->write)
+    {
+        ack = twi_dev->write(twi_dev->ctx, data);
+    }
+
+    if (ack != TWI_ACK)
+        twi_stats.nacks++;
+    return ack;
+}
+
+
+/*
+ * Function: twi_bus_read()
+ * Purpose:  Move one byte from the addressed device to Master.
+ * Input:    ack ACK/NACK value answered by Master
+ * Returns:  Received data byte
+ */
+static uint8_t twi_bus_read(uint8_t ack)
+{
+    twi_stats.bytes++;
+    twi_bus_clocks(9);
+
+    if (twi_dev == NULL || twi_dev->read == NULL)
+        return 0xff;
+    return twi_dev->read(twi_dev->ctx, ack);
+}
+
+
+/*
+ * Function: twi_bus_stop()
+ * Purpose:  Stop condition, release the addressed device.
+ * Returns:  none
+ */
+static void twi_bus_stop(void)
+{
+    twi_bus_clocks(1);
+    if (twi_dev && twi_dev->stop)
+        twi_dev->stop(twi_dev->ctx);
+    twi_dev = NULL;
+}
+
+
+/*
+ * Function: twi_bit_rate()
+ * Purpose:  Convert SCL frequency to TWI bit rate register value.
+ * Input:    scl SCL frequency in Hz
+ * Returns:  TWBR value, limited to the range allowed in Master mode
+ */
+static uint8_t twi_bit_rate(uint32_t scl)
+{
+    uint32_t div = F_CPU / scl;
+
+    if (div < 16 + 2*TWI_BIT_RATE_MIN)
+        return TWI_BIT_RATE_MIN;
+    if (div > 16 + 2*255UL)
+        return 255;
+    return (div - 16) / 2;
+}
+
+
+/*
+ * Function: twi_device_rate()
+ * Purpose:  Look up TWI bit rate register value for one device.
+ * Input:    addr Slave address
+ * Returns:  TWBR value from the speed profile, or the default one
+ */
+static uint8_t twi_device_rate(uint8_t addr)
+{
+    for (uint8_t i = 0; i < TWI_SPEED_SLOTS; i++)
+    {
+        if (twi_speed[i].addr == addr)
+            return twi_speed[i].rate;
+    }
+    return twi_default_rate;
+}
+
+
+/*
+ * Function: twi_run()
+ * Purpose:  Execute one queued transaction on the simulated bus.
+ * Input:    xfer Transaction descriptor
+ * Returns:  TWI_XFER_DONE or TWI_XFER_NACK
+ */
+static uint8_t twi_run(twi_xfer_t *xfer)
+{
+    uint8_t reading = ((xfer->hlen + xfer->wlen) == 0 && xfer->rlen != 0);
+    uint8_t retried = 0;
+
+    twi_rate = twi_device_rate(xfer->addr);
+    twi_bus_start();
+    for (;;)
+    {
+        if (twi_bus_write((xfer->addr<<1) | (reading ? TWI_READ : TWI_WRITE)) != TWI_ACK)
+        {
+            if (retried || twi_rate >= twi_default_rate)
+                break;
+
+            /* Device is not able to run fast, use default clock from now on */
+            for (uint8_t i = 0; i < TWI_SPEED_SLOTS; i++)
+            {
+                if (twi_speed[i].addr == xfer->addr)
+                    twi_speed[i].rate = twi_default_rate;
+            }
+            retried = 1;
+            reading = ((xfer->hlen + xfer->wlen) == 0 && xfer->rlen != 0);
+            twi_bus_stop();
+            twi_rate = twi_default_rate;
+            twi_bus_start();
+            continue;
+        }
+
+        if (!reading)
+        {
+            uint16_t i;
+
+            for (i = 0; i < xfer->hlen; i++)
+            {
+                if (twi_bus_write(xfer->hdr[i]) != TWI_ACK)
+                    break;
+            }
+            if (i < xfer->hlen)
+                break;
+            for (i = 0; i < xfer->wlen; i++)
+            {
+                if (twi_bus_write(xfer->wbuf[i]) != TWI_ACK)
+                    break;
+            }
+            if (i < xfer->wlen)
+                break;
+            if (xfer->rlen == 0)
+            {
+                twi_bus_stop();
+                return TWI_XFER_DONE;
+            }
+
+            /* Repeated Start for the read phase */
+            reading = 1;
+            twi_bus_start();
+            continue;
+        }
+
+        for (uint8_t i = 0; i < xfer->rlen; i++)
+            xfer->rbuf[i] = twi_bus_read(i < xfer->rlen - 1 ? TWI_ACK : TWI_NACK);
+        twi_bus_stop();
+        return TWI_XFER_DONE;
+    }
+
+    twi_bus_stop();
+    return TWI_XFER_NACK;
+}
+
+
+/*
+ * Function: twi_init()
+ * Purpose:  Set SCL frequency, there is no unit to initialize.
+ * Returns:  none
+ */
+void twi_init(void)
+{
+    TWBR = twi_default_rate;
+}
+
+
+void twi_set_clock(uint32_t scl)
+{
+    twi_default_rate = twi_bit_rate(scl);
+    TWBR = twi_default_rate;
+}
+
+
+uint8_t twi_set_device_clock(uint8_t addr, uint32_t scl)
+{
+    uint8_t slot = TWI_SPEED_SLOTS;
+
+    for (uint8_t i = 0; i < TWI_SPEED_SLOTS; i++)
+    {
+        if (twi_speed[i].addr == addr)
+        {
+            slot = i;
+            break;
+        }
+        if (twi_speed[i].addr == 0 && slot == TWI_SPEED_SLOTS)
+            slot = i;
+    }
+    if (slot == TWI_SPEED_SLOTS)
+        return 1;
+
+    twi_speed[slot].addr = addr;
+    twi_speed[slot].rate = twi_bit_rate(scl);
+    return 0;
+}
+
+
+uint32_t twi_get_device_clock(uint8_t addr)
+{
+    return F_CPU / (16 + 2*(uint32_t)twi_device_rate(addr));
+}
+
+
+void twi_start(void)
+{
+    twi_rate = twi_default_rate;
+    twi_bus_start();
+}
+
+
+uint8_t twi_write(uint8_t data)
+{
+    return twi_bus_write(data);
+}
+
+
+uint8_t twi_read(uint8_t ack)
+{
+    return twi_bus_read(ack);
+}
+
+
+void twi_stop(void)
+{
+    twi_bus_stop();
+}
+
+
+uint8_t twi_test_address(uint8_t addr)
+{
+    uint8_t ack;
+
+    twi_start();
+    ack = twi_write((addr<<1) | TWI_WRITE);
+    twi_stop();
+
+    return ack;
+}
+
+
+void twi_readfrom_mem_into(uint8_t addr, uint8_t memaddr, volatile uint8_t *buf, uint8_t nbytes)
+{
+    twi_start();
+    if (twi_write((addr<<1) | TWI_WRITE) == 0)
+    {
+        twi_write(memaddr);
+        twi_stop();
+
+        twi_start();
+        twi_write((addr<<1) | TWI_READ);
+        for (uint8_t i = 0; i < nbytes; i++)
+            buf[i] = twi_read(i < nbytes - 1 ? TWI_ACK : TWI_NACK);
+    }
+    twi_stop();
+}
+
+
+/*
+ * Function: twi_submit()
+ * Purpose:  Append one transaction to the queue and, unless the queue
+ *           is already being drained, run all queued transactions.
+ * Input:    xfer Transaction descriptor
+ * Returns:  0 if queued, 1 if the queue is full
+ * Note:     Callbacks run with the global interrupt flag cleared, as
+ *           they do in TWI_vect. Transactions submitted by a callback
+ *           or by an interrupt raised meanwhile are run by the same loop.
+ */
+uint8_t twi_submit(twi_xfer_t *xfer)
+{
+    uint8_t next = (twi_head + 1) & (TWI_QUEUE_SIZE - 1);
+
+    if (next == twi_tail)
+        return 1;
+
+    xfer->status = TWI_XFER_QUEUED;
+    twi_queue[twi_head] = xfer;
+    twi_head = next;
+
+    if (twi_active)
+        return 0;
+
+    twi_active = 1;
+    while (twi_tail != twi_head)
+    {
+        twi_xfer_t *cur = twi_queue[twi_tail];
+        uint8_t status;
+
+        cur->status = TWI_XFER_BUSY;
+        status = twi_run(cur);
+        twi_tail = (twi_tail + 1) & (TWI_QUEUE_SIZE - 1);
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            cur->status = status;
+            if (cur->callback)
+                cur->callback(cur);
+        }
+    }
+    twi_active = 0;
+
+    return 0;
+}
+
+
+uint8_t twi_busy(void)
+{
+    return twi_active;
+}
+
+
+uint8_t twi_transfer(twi_xfer_t *xfer)
+{
+    if (twi_submit(xfer) != 0)
+        return 1;
+
+    return (xfer->status == TWI_XFER_DONE) ? 0 : 1;
+}
+
+
+void twi_host_attach(uint8_t addr, const twi_host_device_t *dev)
+{
+    twi_devices[addr & 0x7f] = dev;
+}
+
+
+const twi_host_device_t *twi_host_get_device(uint8_t addr)
+{
+    return twi_devices[addr & 0x7f];
+}
+
+
+void twi_host_get_stats(twi_host_stats_t *stats)
+{
+    *stats = twi_stats;
+}
+
+
+void twi_host_reset_stats(void)
+{
+    twi_stats = (twi_host_stats_t){0};
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef TWI_HOST_H
+#define TWI_HOST_H
+
+/**
+ * @file
+ * @defgroup twi_host Host TWI Backend <twi_host.h>
+ * @code #include <twi_host.h> @endcode
+ *
+ * @brief Host replacement of the TWI unit for off-target builds.
+ *
+ * Implements the functions of twi.h on a PC. Slave devices are C models
+ * attached to an address by twi_host_attach(); every bus byte is delivered
+ * to the model and the virtual clock of the HAL is advanced by the time the
+ * byte takes on a real bus at the current SCL frequency (9 clocks per byte,
+ * 1 clock per Start or Stop). Queued transactions complete before
+ * twi_submit() returns, completion callbacks run in submission order.
+ *
+ * @note Only available when __AVR__ is not defined.
+ * @{
+ */
+
+// -- Includes ---------------------------------------------
+#include <twi.h>
+
+
+// -- Types ------------------------------------------------
+/**
+ * @brief  Bus interface of one simulated slave device.
+ * @note   Any callback may be NULL. A missing start or write callback
+ *         acknowledges, a missing read callback returns 0xff.
+ */
+typedef struct twi_host_device {
+    uint8_t (*start)(void *ctx, uint8_t rw); /**< @brief Address matched after (repeated) Start, return TWI_ACK or TWI_NACK */
+    uint8_t (*write)(void *ctx, uint8_t data); /**< @brief Data byte from Master, return TWI_ACK or TWI_NACK */
+    uint8_t (*read)(void *ctx, uint8_t ack); /**< @brief Return the next byte, ack is what Master answers */
+    void (*stop)(void *ctx);                /**< @brief Stop condition */
+    void *ctx;                              /**< @brief Passed to every callback */
+} twi_host_device_t;
+
+/**
+ * @brief  Bus statistics of the host backend.
+ */
+typedef struct {
+    uint32_t transactions;  /**< @brief Start conditions, repeated ones included */
+    uint32_t bytes;         /**< @brief Bytes on the bus, address bytes included */
+    uint32_t nacks;         /**< @brief Bytes answered by NACK or sent to an empty address */
+    uint64_t bus_ns;        /**< @brief Time the bus was busy */
+} twi_host_stats_t;
+
+
+// -- Function prototypes ----------------------------------
+/**
+ * @brief  Attach a simulated device to a slave address.
+ * @param  addr 7-bit slave address
+ * @param  dev Device interface, NULL detaches the address
+ * @return none
+ */
+void twi_host_attach(uint8_t addr, const twi_host_device_t *dev);
+
+
+/**
+ * @brief  Device attached to a slave address.
+ * @param  addr 7-bit slave address
+ * @return Device interface or NULL, lets other bus models (eg. a simulator
+ *         of the whole MCU) reach the attached devices
+ */
+const twi_host_device_t *twi_host_get_device(uint8_t addr);
+
+
+/**
+ * @brief  Read bus statistics collected since the last reset.
+ * @param  stats Structure to be filled
+ * @return none
+ */
+void twi_host_get_stats(twi_host_stats_t *stats);
+
+
+/**
+ * @brief  Clear bus statistics.
+ * @return none
+ */
+void twi_host_reset_stats(void);
+
+/** @} */
+
+#endif
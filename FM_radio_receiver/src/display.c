@@ -0,0 +1,263 @@
+/* src/display.c */
+
+#include <stdio.h>
+#include <string.h>
+#include "oled.h"
+#include "si4703.h"
+#include "bandscan.h"
+#include "bigdigits.h"
+#include "display.h"
+
+#define RT_COLUMNS 21           // NORMALSIZE characters per display line
+#define RT_SCROLL_TICKS 8       // display ticks per RadioText scroll step (~260 ms)
+#define RT_GAP 3                // spaces between the end and the repeated start of the text
+
+// frequency line: four big digits and the decimal point on display pages 0-2
+#define FREQ_DIGITS 4           // 100 MHz, 10 MHz, 1 MHz and 100 kHz digit
+#define DIGIT_PITCH (BIGDIGIT_WIDTH + 3)
+#define DIGIT_BLANK 10          // hundreds digit below 100 MHz
+#define DIGIT_NONE 0xff         // nothing drawn in the digit place
+#define DOT_X (3 * DIGIT_PITCH)
+#define DOT_SIZE 3
+#define UNIT_X (DOT_X + DOT_SIZE + 3 + DIGIT_PITCH + 2)
+
+static const uint8_t digitX[FREQ_DIGITS] = { 0, DIGIT_PITCH, 2 * DIGIT_PITCH, DOT_X + DOT_SIZE + 3 };
+static uint8_t shownDigits[FREQ_DIGITS];   // digits on the screen
+
+// spectrum graph: one bar per column over the band, growing up from SPECTRUM_BASE
+#define SPECTRUM_TOP 8          // first row under the text line
+#define SPECTRUM_BASE 62        // lowest bar row, the MHz scale is drawn below it
+#define SPECTRUM_HEIGHT (SPECTRUM_BASE - SPECTRUM_TOP + 1)
+#define SPECTRUM_RSSI_MAX 60    // RSSI of a full height bar
+
+// screen drawn last, switching the screen redraws it whole
+#define SCREEN_NONE 0
+#define SCREEN_RADIO 1
+#define SCREEN_SPECTRUM 2
+
+static uint8_t screen = SCREEN_NONE;
+
+/*
+ * Function for drawing the frequency in big digits, only the digits that
+ * differ from the ones on the screen are drawn, so a tuning step of 100 kHz
+ * touches one digit
+ */
+static void draw_frequency(uint16_t freq) {
+    uint8_t digits[FREQ_DIGITS];
+
+    // 10110 (101.1 MHz) becomes 1, 0, 1, 1
+    freq /= 10;
+    for (uint8_t i = FREQ_DIGITS; i > 0; i--) {
+        digits[i - 1] = freq % 10;
+        freq /= 10;
+    }
+    if (digits[0] == 0) digits[0] = DIGIT_BLANK;
+
+    // the decimal point and the unit do not change, they are drawn with the first digits
+    if (shownDigits[0] == DIGIT_NONE) {
+        oled_fillRect(DOT_X, 8 * BIGDIGIT_PAGES - DOT_SIZE, DOT_X + DOT_SIZE - 1, 8 * BIGDIGIT_PAGES - 1, WHITE);
+        oled_charMode(NORMALSIZE);
+        oled_goto_xpix_y(UNIT_X, BIGDIGIT_PAGES - 1);
+        oled_puts("MHz");
+    }
+
+    for (uint8_t i = 0; i < FREQ_DIGITS; i++) {
+        if (digits[i] == shownDigits[i]) continue;
+
+        if (digits[i] == DIGIT_BLANK) {
+            oled_fillRect(digitX[i], 0, digitX[i] + BIGDIGIT_WIDTH - 1, 8 * BIGDIGIT_PAGES - 1, BLACK);
+        } else {
+            for (uint8_t page = 0; page < BIGDIGIT_PAGES; page++) {
+                oled_drawColumns(digitX[i], page, bigDigits[digits[i]][page], BIGDIGIT_WIDTH);
+            }
+        }
+        shownDigits[i] = digits[i];
+    }
+}
+
+/*
+ * Draws the RadioText on the last display line, texts longer than the line
+ * scroll by one character every RT_SCROLL_TICKS calls
+ */
+void draw_radiotext(void) {
+    static uint8_t offset = 0;
+    static uint8_t ticks = 0;
+    char line[RT_COLUMNS + 1];
+    uint8_t len = strlen(rdsData.radioText);
+
+    // padding of a text that is not fully received yet is not scrolled
+    while (len > 0 && rdsData.radioText[len - 1] == ' ') len--;
+
+    if (rdsData.updated & RDS_UPD_RT) {
+        rdsData.updated &= ~RDS_UPD_RT;
+        offset = 0;
+        ticks = 0;
+    } else if (len <= RT_COLUMNS || ++ticks < RT_SCROLL_TICKS) {
+        return;
+    } else {
+        ticks = 0;
+        if (++offset >= len + RT_GAP) offset = 0;
+    }
+
+    for (uint8_t i = 0; i < RT_COLUMNS; i++) {
+        uint8_t pos = (len > RT_COLUMNS) ? (offset + i) % (len + RT_GAP) : i;
+        line[i] = (pos < len) ? rdsData.radioText[pos] : ' ';
+    }
+    line[RT_COLUMNS] = '\0';
+
+    oled_charMode(NORMALSIZE);
+    oled_gotoxy(0, 7);
+    oled_puts(line);
+}
+
+void draw_display(void) {
+    char buffer[32];
+    
+    // static variables for storing the previous state
+    // initialized with mock values
+    static uint16_t last_freq = 0;
+    static uint8_t last_vol = 255;
+    static uint8_t last_mute = 255;
+    static int last_rssi = -1;
+
+    int current_rssi = si4703_get_rssi();
+
+    // coming from another screen, everything is drawn again
+    if (screen != SCREEN_RADIO) {
+        screen = SCREEN_RADIO;
+        oled_clear_buffer();
+        last_freq = 0;
+        last_vol = 255;
+        last_mute = 255;
+        last_rssi = -1;
+        memset(shownDigits, DIGIT_NONE, sizeof(shownDigits));
+        rdsData.updated |= RDS_UPD_PS | RDS_UPD_CT | RDS_UPD_RT;
+    }
+
+    // overwrite the changed digits of the frequency
+    if (current_freq != last_freq) {
+        draw_frequency(current_freq);
+        
+        // overwriting with current value
+        last_freq = current_freq;
+    }
+
+    // overwrite volume, mute status and RSSI on change
+    if (is_muted != last_mute || current_vol != last_vol || current_rssi != last_rssi) {
+        
+        oled_charMode(NORMALSIZE);
+        oled_gotoxy(0, 3);
+
+        if (is_muted) {
+            // added spaces to overwrite any residual text
+            oled_puts("Status: MUTED       "); 
+        } else {
+            sprintf(buffer, "Vol:%-2d RSSI:%-3d   ", current_vol, current_rssi);
+            oled_puts(buffer);
+        }
+
+        // overwriting with current values
+        last_mute = is_muted;
+        last_vol = current_vol;
+        last_rssi = current_rssi;
+    }
+
+    // overwrite station name once the RDS decoder has confirmed a change
+    if (rdsData.updated & RDS_UPD_PS) {
+        rdsData.updated &= ~RDS_UPD_PS;
+        
+        oled_charMode(NORMALSIZE);
+        oled_gotoxy(0, 5);
+        oled_puts("Station:"); 
+
+        oled_gotoxy(0, 6);
+
+        // clearing residual characters is handled in clear_rds_buffer function
+        oled_puts(rdsData.stationName);
+    }
+
+    // overwrite RDS clock on change
+    if (rdsData.updated & RDS_UPD_CT) {
+        rdsData.updated &= ~RDS_UPD_CT;
+
+        oled_charMode(NORMALSIZE);
+        oled_gotoxy(RT_COLUMNS - 5, 5);
+        if (rdsData.flags & RDS_FLAG_CT) {
+            sprintf(buffer, "%02d:%02d", rdsData.hour, rdsData.minute);
+            oled_puts(buffer);
+        } else {
+            oled_puts("     ");
+        }
+    }
+
+    draw_radiotext();
+
+    // queue the parts of the buffer that changed, the bus sends them meanwhile
+    oled_flush_async();
+}
+
+/*
+ * Function for the bar height of a column, the strongest of the channels
+ * that fall into it (206 channels over 128 columns, one or two per column)
+ */
+static uint8_t spectrum_height(uint8_t x) {
+    uint8_t first = (uint16_t)x * SCAN_CHANNELS / DISPLAY_WIDTH;
+    uint8_t last = ((uint16_t)(x + 1) * SCAN_CHANNELS - 1) / DISPLAY_WIDTH;
+    uint8_t rssi = 0;
+
+    for (uint8_t ch = first; ch <= last; ch++) {
+        uint8_t value = SCAN_RSSI(scan_get_channel(ch));
+        if (value > rssi) rssi = value;
+    }
+    if (rssi >= SPECTRUM_RSSI_MAX) return SPECTRUM_HEIGHT;
+    return (uint16_t)rssi * SPECTRUM_HEIGHT / SPECTRUM_RSSI_MAX;
+}
+
+void draw_spectrum(void) {
+    char buffer[32];
+    static uint8_t heights[DISPLAY_WIDTH];  // bar heights on the screen
+    static uint16_t last_freq = 0;
+    static uint8_t last_count = 255;
+    const ScanStation *stations;
+    uint8_t count = scan_get_stations(&stations);
+
+    // coming from another screen, draw the empty graph with its MHz scale
+    if (screen != SCREEN_SPECTRUM) {
+        screen = SCREEN_SPECTRUM;
+        oled_clear_buffer();
+        memset(heights, 0, sizeof(heights));
+        for (uint16_t freq = 8800; freq <= FREQ_MAX; freq += 100) {
+            uint8_t x = (uint32_t)((freq - FREQ_MIN) / 10) * DISPLAY_WIDTH / SCAN_CHANNELS;
+            oled_drawPixel(x, SPECTRUM_BASE + 1, WHITE);
+            // longer marks every 5 MHz
+            if (freq % 500 == 0) oled_drawPixel(x + 1, SPECTRUM_BASE + 1, WHITE);
+        }
+        last_freq = 0;
+        last_count = 255;
+    }
+
+    if (current_freq != last_freq || count != last_count) {
+        oled_charMode(NORMALSIZE);
+        oled_gotoxy(0, 0);
+        sprintf(buffer, "%3d.%d MHz  %2u found", current_freq / 100, (current_freq % 100) / 10, count);
+        oled_puts(buffer);
+        last_freq = current_freq;
+        last_count = count;
+    }
+
+    // only the part of a bar that changed is drawn, the dirty ranges keep
+    // the transfer to the changed columns
+    for (uint8_t x = 0; x < DISPLAY_WIDTH; x++) {
+        uint8_t height = spectrum_height(x);
+        if (height == heights[x]) continue;
+
+        if (height > heights[x]) {
+            oled_drawLine(x, SPECTRUM_BASE - heights[x], x, SPECTRUM_BASE + 1 - height, WHITE);
+        } else {
+            oled_drawLine(x, SPECTRUM_BASE + 1 - heights[x], x, SPECTRUM_BASE - height, BLACK);
+        }
+        heights[x] = height;
+    }
+
+    oled_flush_async();
+}
@@ -0,0 +1,34 @@
+/* src/display.h */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+#include "rds.h"
+
+// state shown on the display, owned by main.c
+extern uint16_t current_freq;
+extern uint8_t current_vol;
+extern uint8_t is_muted;
+extern RdsInfo rdsData;
+
+/*
+ * Draws the RadioText on the last display line, texts longer than the line
+ * scroll by one character every RT_SCROLL_TICKS calls
+ */
+void draw_radiotext(void);
+
+/*
+ * Redraws the parts of the screen whose state changed since the last call
+ * and sends them to the display, called every display period
+ */
+void draw_display(void);
+
+/*
+ * Draws the RSSI of the band scan channels as a bar graph of 128 columns
+ * over 87.5-108 MHz, only the bars that changed since the last call are
+ * drawn and sent, called every display period during and after a scan
+ */
+void draw_spectrum(void);
+
+#endif
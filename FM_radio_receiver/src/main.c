@@ -5,6 +5,7 @@
 #include <util/delay.h>
 #include <stdio.h>
 #include "gpio.h"
+#include "hal.h"
 #include "twi.h"
 #include "oled.h"
 #include "uart.h"
@@ -13,103 +14,250 @@
 #include <string.h>
 #include <util/atomic.h>
 #include "rotary_encoder.h"
+#include "display.h"
+#include "scheduler.h"
+#include "debounce.h"
+#include "bandscan.h"
 
 // pin definitions
-#define BTN_PORT      PIND
-#define BTN_DDR       DDRD
-#define BTN_UP_PIN    PD7
-#define BTN_DOWN_PIN  PD6
-// #define BTN_RST_PIN   PD4
-#define BTN_MUTE_PIN  PD5
+// buttons of the debouncer on PD4-PD7, index = pin - PD4
+#define BTN_RESET     0   // encoder switch, PD4
+#define BTN_MUTE      1   // PD5
+#define BTN_DOWN      2   // PD6
+#define BTN_UP        3   // PD7
 #define RADIO_RST_PORT PORTC
 #define RADIO_RST_DDR  DDRC
 #define RADIO_RST_PIN  PC0
 
+// task ids, the order is the priority when more tasks are due at once
+enum { TASK_RDS, TASK_TUNER, TASK_INPUT, TASK_DISPLAY, TASK_COUNT };
+
+#define INPUT_PERIOD_MS   10    // encoder and button event polling
+#define DISPLAY_PERIOD_MS 33
+
+// encoder acceleration, velocity in detents per ENC_VELOCITY_MS
+#define TUNE_FAST_VELOCITY   2    // from here one detent tunes 0.2 MHz
+#define TUNE_RAPID_VELOCITY  4    // from here one detent tunes 0.5 MHz
+
 // global variables
-volatile uint8_t update_display_flag = 0;
 uint16_t current_freq = 9500; 
 uint8_t current_vol = 10;
 uint8_t is_muted = 0;
 RdsInfo rdsData; 
 
+static uint8_t seeking = 0;         // seek running in the background
+static uint8_t scanning = 0;        // band scan running, it owns the tuner
+static uint8_t spectrum = 0;        // spectrum of the last scan on screen until the next input
+static uint8_t resetting = 0;       // power-up of the tuner running, seek and scan wait for it
+
 void clear_rds_buffer(void) {
-    for (int i = 0; i < 9; i++) rdsData.stationName[i] = (i == 8) ? '\0' : ' ';
-    rdsData.ready = 0;
+    rds_clear(&rdsData);
 }
 
-void draw_display(void) {
-    char buffer[32];
-    
-    // static variables for storing the previous state
-    // initialized with mock values
-    static uint16_t last_freq = 0;
-    static uint8_t last_vol = 255;
-    static uint8_t last_mute = 255;
-    static int last_rssi = -1;
-    static char last_rds[10] = "";
-
-    int current_rssi = si4703_get_rssi();
-
-    // overwrite frequency on change
-    if (current_freq != last_freq) {
-        oled_gotoxy(0, 0);
-        oled_charMode(DOUBLESIZE);
-        sprintf(buffer, "%d.%d MHz", current_freq / 100, (current_freq % 100) / 10);
-        oled_puts(buffer);
-        
-        // overwriting with current value
-        last_freq = current_freq;
+ISR(TIMER0_OVF_vect) {
+    hal_tick(4);
+#if !ENCODER_USE_PCINT
+    encoder_update();
+#endif
+    debounce_tick();
+}
+
+/*
+ * Function for the tuning step of one encoder detent, faster turning tunes in bigger steps
+ */
+static uint8_t tune_step(uint8_t velocity) {
+    if (velocity >= TUNE_RAPID_VELOCITY) return 50;
+    if (velocity >= TUNE_FAST_VELOCITY) return 20;
+    return 10;
+}
+
+/*
+ * Task decoding the RDS groups captured by the GPIO2 interrupt
+ */
+static void task_rds(void) {
+    si4703_update_rds(&rdsData);
+}
+
+/*
+ * Function for following a band scan, the scan ends on the strongest station
+ */
+static void scan_update(void) {
+    ScanStatus status = scan_poll();
+
+    // show the channel being measured
+    current_freq = FREQ_MIN + scan_get_progress() * 10;
+    sched_trigger(TASK_DISPLAY);
+    if (status == SCAN_BUSY) return;
+
+    const ScanStation *stations;
+    uint8_t count = scan_get_stations(&stations);
+    char buffer[40];
+    sprintf(buffer, "Scan: %u stations, %lu ms\r\n", count, (unsigned long)scan_get_time_ms());
+    uart_puts(buffer);
+
+    scanning = 0;
+    current_freq = si4703_get_tuning_freq();
+    if (status == SCAN_DONE && count > 0) {
+        current_freq = FREQ_MIN + stations[0].channel * 10;
+        si4703_request_freq(current_freq);
     }
+    clear_rds_buffer();
+}
 
-    // overwrite volume, mute status and RSSI on change
-    if (is_muted != last_mute || current_vol != last_vol || current_rssi != last_rssi) {
-        
-        oled_charMode(NORMALSIZE);
-        oled_gotoxy(0, 3);
-
-        if (is_muted) {
-            // added spaces to overwrite any residual text
-            oled_puts("Status: MUTED       "); 
-        } else {
-            sprintf(buffer, "Vol:%-2d RSSI:%-3d   ", current_vol, current_rssi);
-            oled_puts(buffer);
-        }
+/*
+ * Task following a running tune, seek or band scan
+ */
+static void task_tuner(void) {
+    if (scanning) {
+        scan_update();
+        return;
+    }
 
-        // overwriting with current values
-        last_mute = is_muted;
-        last_vol = current_vol;
-        last_rssi = current_rssi;
+    Si4703Status status = si4703_poll();
+    if (resetting && status == SI4703_DONE) {
+        // powered up, the defaults go out with the tune of the reset request
+        resetting = 0;
+        si4703_set_volume(current_vol);
+        si4703_set_mute(is_muted);
+        return;
+    }
+    if (status != SI4703_IDLE && seeking) {
+        // show the frequency the seek is passing through, a manual
+        // tune shows its target from the start
+        current_freq = si4703_get_tuning_freq();
+        sched_trigger(TASK_DISPLAY);
+        if (status != SI4703_BUSY) seeking = 0;
     }
+}
 
-    // overwrite RSSI on change
-    // compare new string with old string using strcmp
-    if (strcmp(rdsData.stationName, last_rds) != 0) {
-        
-        oled_gotoxy(0, 5);
-        oled_puts("Station:"); 
+/*
+ * Task handling the encoder and the button events, it never waits for a button
+ */
+static void task_input(void) {
+    static uint8_t held_long = 0;   // buttons whose press made a scan or cancelled one, until their release
+    uint8_t event;
 
-        oled_gotoxy(0, 6);
+    // --- ROTARY ENCODER LOGIC ---
+    int8_t delta = encoder_get_delta();
 
-        // clearing residual characters is handled in clear_rds_buffer function
-        oled_puts(rdsData.stationName);
+    if (delta != 0 && spectrum && !scanning) {
+        // leaving the spectrum, the knob tunes as usual
+        spectrum = 0;
+        sched_trigger(TASK_DISPLAY);
+    }
+
+    if (delta != 0 && scanning) {
+        // Turning the knob aborts a running scan
+        scan_cancel();
+    } else if (delta != 0 && seeking) {
+        // Turning the knob aborts a running seek
+        si4703_cancel();
+    } else if (delta != 0) {
+        // Manual Tuning, the tuner task tunes the latest target only
+        // Assuming freq format: 10150 = 101.5MHz, so +/- 10 is 0.1MHz
+        int16_t freq = current_freq - delta * tune_step(encoder_get_velocity());
+
+        // Simple bounds checking, wraps around the band
+        if (freq > FREQ_MAX) freq = FREQ_MIN;
+        if (freq < FREQ_MIN) freq = FREQ_MAX;
+        current_freq = freq;
+
+        si4703_request_freq(current_freq);
         
-        // overwriting with current values
-        strcpy(last_rds, rdsData.stationName);
+
+        sched_trigger(TASK_DISPLAY); // Update screen on any movement
     }
 
-    // draw display
-    oled_display();
-}
+    // --- BUTTONS, debounced by the Timer0 interrupt ---
+    while ((event = debounce_get_event()) != DEBOUNCE_NONE) {
+        uint8_t button = DEBOUNCE_BUTTON(event);
+        uint8_t type = DEBOUNCE_TYPE(event);
 
-ISR(TIMER1_OVF_vect) {
-    update_display_flag = 1;
-}
+        if (type == DEBOUNCE_PRESS && spectrum && !scanning) {
+            spectrum = 0;
+            sched_trigger(TASK_DISPLAY);
+        }
 
-ISR(TIMER0_OVF_vect) {
-    encoder_update();
+        if (button == BTN_UP || button == BTN_DOWN) {
+            // short press seeks, holding the button scans the band
+            if (type == DEBOUNCE_PRESS && scanning) {
+                // the press cancels the scan, its LONG and RELEASE start nothing
+                scan_cancel();
+                held_long |= 1 << button;
+            } else if (type == DEBOUNCE_LONG && !(held_long & (1 << button)) && !scanning && !resetting) {
+                held_long |= 1 << button;
+                uart_puts("Scan\r\n");
+                scan_start(SCAN_FULL, SCAN_DWELL_MS, SCAN_PI_MS, &rdsData);
+                scanning = 1;
+                spectrum = 1;
+                seeking = 0;
+            } else if (type == DEBOUNCE_RELEASE && (held_long & (1 << button))) {
+                held_long &= ~(1 << button);
+            } else if (type == DEBOUNCE_RELEASE && !scanning && !resetting) {
+                uart_puts(button == BTN_UP ? "Seek UP\r\n" : "Seek DOWN\r\n");
+                clear_rds_buffer();
+                si4703_seek_start(button == BTN_UP ? SEEK_UP : SEEK_DOWN);
+                seeking = 1;
+            }
+            continue;
+        }
+        if (type != DEBOUNCE_PRESS) continue;
+        if (scanning) {
+            // any other button only stops the scan
+            scan_cancel();
+            continue;
+        }
+
+        switch (button) {
+        case BTN_RESET:
+            uart_puts(">> RESET TRIGGERED <<\r\n");
+            
+            // Re-init and set defaults, the tuner task runs the power-up
+            si4703_reset_start(&RADIO_RST_PORT, &RADIO_RST_DDR, RADIO_RST_PIN);
+            current_freq = 9500; 
+            current_vol = 10; 
+            is_muted = 0;
+            seeking = 0;
+            resetting = 1;
+            
+            si4703_request_freq(current_freq); 
+            clear_rds_buffer();
+            
+            sched_trigger(TASK_DISPLAY);
+            break;
+
+        case BTN_MUTE:
+            is_muted = !is_muted;
+            // during a reset the tuner task sets it once the tuner is up
+            if (!resetting) {
+                si4703_set_mute(is_muted);
+                si4703_commit();
+            }
+            sched_trigger(TASK_DISPLAY);
+            break;
+        }
+    }
 }
 
+/*
+ * Task sending the changed parts of the screen, the spectrum from the
+ * start of a band scan until the next input
+ */
+static void task_display(void) {
+    if (spectrum) {
+        draw_spectrum();
+    } else {
+        draw_display();
+    }
+}
 
+// period and run budget in ms, RDS first so the ring buffer is drained before UI work
+static SchedTask tasks[TASK_COUNT] = {
+    [TASK_RDS]     = { task_rds,     20,                 4 },
+    [TASK_TUNER]   = { task_tuner,   SI4703_POLL_MS,     4 },
+    [TASK_INPUT]   = { task_input,   INPUT_PERIOD_MS,    8 },
+    [TASK_DISPLAY] = { task_display, DISPLAY_PERIOD_MS, 30 },
+};
 
 int main(void) {
     _delay_ms(500);
@@ -135,11 +283,8 @@ int main(void) {
 
     _delay_ms(100);
 
-    // button setup
-    gpio_mode_input_pullup(&BTN_DDR, BTN_UP_PIN);
-    gpio_mode_input_pullup(&BTN_DDR, BTN_DOWN_PIN);
-    //gpio_mode_input_pullup(&BTN_DDR, BTN_RST_PIN);
-    gpio_mode_input_pullup(&BTN_DDR, BTN_MUTE_PIN);
+    // button setup, sampled by the Timer0 interrupt
+    debounce_init();
 
     // 4. Si4703 Rádio
     // Pokud se to zasekne, uvidíte v konzoli poslední zprávu "DEBUG: OLED OK..."
@@ -147,113 +292,20 @@ int main(void) {
     
     uart_puts("DEBUG: Radio Init OK.\r\n");
     
+    // volume is written together with the first tune
     si4703_set_volume(current_vol);
     si4703_set_freq(current_freq);
     clear_rds_buffer();
 
-    // 5. Timer
-    tim1_ovf_33ms(); 
-    tim1_ovf_enable();
-
+    // 5. Timer, Timer0 drives hal_millis() of the scheduler and the debouncer
     tim0_ovf_4ms(); 
     tim0_ovf_enable();
 
     uart_puts("DEBUG: Smycka bezi.\r\n");
 
-    int8_t seek_accumulator = 0; // Tracks rotation momentum
-    uint8_t btn_was_pressed = 0;
-
+    sched_init(tasks, TASK_COUNT);
     while (1) {
-        // --- ROTARY ENCODER LOGIC ---
-        int8_t delta = encoder_get_delta();
-
-        if (delta != 0) {
-            // 1. Update Seek Accumulator (Momentum)
-            // If turning same direction, adds up. If turning opposite, subtracts.
-            if ((delta > 0 && seek_accumulator < 0) || (delta < 0 && seek_accumulator > 0)) {
-                seek_accumulator = 0; // Reset momentum if direction reverses abruptly
-            }
-            seek_accumulator += delta;
-            
-            
-            // 3. Normal Manual Tuning (+/- 0.1 MHz)
-            // Assuming freq format: 10150 = 101.5MHz, so +/- 10 is 0.1MHz
-            if (delta > 0) current_freq -= 10;
-            else current_freq += 10;
-
-            // Simple bounds checking
-            if (current_freq > 10800) current_freq = 8750;
-            if (current_freq < 8750) current_freq = 10800;
-
-            si4703_set_freq(current_freq);
-            
-
-            update_display_flag = 1; // Update screen on any movement
-        }
-
-        if (encoder_button_pressed()) {
-            if (!btn_was_pressed) {
-                _delay_ms(20); // Debounce
-                
-                if (encoder_button_pressed()) {
-                    uart_puts(">> RESET TRIGGERED <<\r\n");
-                    
-                    // Re-init and set defaults
-                    si4703_init(&RADIO_RST_PORT, &RADIO_RST_DDR, RADIO_RST_PIN);
-                    current_freq = 9500; 
-                    current_vol = 10; 
-                    is_muted = 0;
-                    seek_accumulator = 0; // Clear seek memory
-                    
-                    si4703_set_freq(current_freq); 
-                    si4703_set_volume(current_vol);
-                    
-                    btn_was_pressed = 1;
-                    update_display_flag = 1;
-                }
-            }
-        } else {
-            btn_was_pressed = 0;
-        }
-
-        if (gpio_read(&BTN_PORT, BTN_MUTE_PIN) == 0) {
-            _delay_ms(50);
-            if (gpio_read(&BTN_PORT, BTN_MUTE_PIN) == 0) {
-                is_muted = !is_muted;
-                si4703_set_volume(is_muted ? 0 : 10);
-                while(gpio_read(&BTN_PORT, BTN_MUTE_PIN) == 0);
-            }
-        }
-        if (gpio_read(&BTN_PORT, BTN_DOWN_PIN) == 0) {
-            _delay_ms(50);
-            if (gpio_read(&BTN_PORT, BTN_DOWN_PIN) == 0) {
-                uart_puts("Seek DOWN\r\n");
-                clear_rds_buffer();
-                uint16_t ret = si4703_seek(0);
-                if (ret) current_freq = ret;
-                else { current_freq = 10800; si4703_set_freq(current_freq); }
-                while(gpio_read(&BTN_PORT, BTN_DOWN_PIN) == 0);
-            }
-        }
-        if (gpio_read(&BTN_PORT, BTN_UP_PIN) == 0) {
-            _delay_ms(50);
-            if (gpio_read(&BTN_PORT, BTN_UP_PIN) == 0) {
-                uart_puts("Seek UP\r\n");
-                clear_rds_buffer();
-                uint16_t ret = si4703_seek(1);
-                if (ret) current_freq = ret;
-                else { current_freq = 8750; si4703_set_freq(current_freq); }
-                while(gpio_read(&BTN_PORT, BTN_UP_PIN) == 0);
-            }
-        }
-
-        // --- RDS & DISPLAY TASKS ---
-        si4703_update_rds(&rdsData);
-
-        if (update_display_flag) {
-            update_display_flag = 0;
-            draw_display();
-        }
+        sched_run();
     }
     return 0;
-}
+}
\ No newline at end of file